@@ -0,0 +1,1051 @@
+#include "FakePgServer.hpp"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <random>
+#include <stdexcept>
+#include <string_view>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+constexpr int32_t kProtocolV3    = 196608; // 3.0
+constexpr int32_t kSslRequest    = 80877103;
+constexpr int32_t kGssEncRequest = 80877104;
+constexpr int32_t kCancelRequest = 80877102;
+constexpr int32_t kInt4Oid       = 23;
+constexpr int32_t kTextOid       = 25;
+constexpr size_t  kFlushAt       = 64 * 1024; // large results go out in pieces instead of one buffer
+
+#ifdef MSG_NOSIGNAL
+constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+constexpr int kSendFlags = 0; // SO_NOSIGPIPE is set on the socket instead
+#endif
+
+struct ProtocolError : std::runtime_error {
+   using std::runtime_error::runtime_error;
+};
+
+struct Token {
+   char        kind; // 'w' word or number, 'i' quoted identifier, 's' string literal, 'p' punctuation
+   std::string text;
+};
+using Statement = std::vector<Token>;
+
+bool is(const Token& token, std::string_view keyword) {
+   return (token.kind == 'w' || token.kind == 'i') && token.text.size() == keyword.size() &&
+          std::equal(token.text.begin(), token.text.end(), keyword.begin(),
+                     [](char a, char b) { return std::toupper(static_cast<unsigned char>(a)) == b; });
+}
+
+bool isNumber(const Token& token) {
+   return token.kind == 'w' && !token.text.empty() &&
+          std::all_of(token.text.begin(), token.text.end(),
+                      [](char c) { return std::isdigit(static_cast<unsigned char>(c)); });
+}
+
+std::string upper(std::string text) {
+   std::transform(text.begin(), text.end(), text.begin(),
+                  [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+   return text;
+}
+
+// Splits a query string into statements of tokens. Comments are dropped and quotes respected, so a
+// ';' inside a literal doesn't end the statement.
+std::vector<Statement> splitStatements(const std::string& sql) {
+   std::vector<Statement> statements(1);
+   auto quoted = [&](size_t& i, char quote) { // i is on the opening quote; leaves i past the closing one
+      std::string text;
+      for (++i; i < sql.size(); ++i) {
+         if (sql[i] == quote) {
+            if (i + 1 < sql.size() && sql[i + 1] == quote) {
+               text += quote;
+               ++i;
+               continue;
+            }
+            ++i;
+            break;
+         }
+         text += sql[i];
+      }
+      return text;
+   };
+   for (size_t i = 0; i < sql.size();) {
+      char c = sql[i];
+      if (std::isspace(static_cast<unsigned char>(c))) {
+         ++i;
+      } else if (c == '-' && i + 1 < sql.size() && sql[i + 1] == '-') {
+         i = std::min(sql.find('\n', i), sql.size());
+      } else if (c == '/' && i + 1 < sql.size() && sql[i + 1] == '*') {
+         size_t end = sql.find("*/", i + 2);
+         i          = end == std::string::npos ? sql.size() : end + 2;
+      } else if (c == '\'') {
+         statements.back().push_back({'s', quoted(i, '\'')});
+      } else if (c == '"') {
+         statements.back().push_back({'i', quoted(i, '"')});
+      } else if (c == ';') {
+         statements.emplace_back();
+         ++i;
+      } else if (std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '$' || c == '.') {
+         size_t start = i;
+         while (i < sql.size() && (std::isalnum(static_cast<unsigned char>(sql[i])) || sql[i] == '_' ||
+                                   sql[i] == '$' || sql[i] == '.')) {
+            ++i;
+         }
+         statements.back().push_back({'w', sql.substr(start, i - start)});
+      } else {
+         statements.back().push_back({'p', std::string(1, c)});
+         ++i;
+      }
+   }
+   statements.erase(std::remove_if(statements.begin(), statements.end(),
+                                   [](const Statement& statement) { return statement.empty(); }),
+                    statements.end());
+   return statements;
+}
+
+// Index of the first token matching keyword at or after `from`, or statement.size()
+size_t find(const Statement& statement, std::string_view keyword, size_t from = 0) {
+   for (size_t i = from; i < statement.size(); ++i) {
+      if (is(statement[i], keyword)) {
+         return i;
+      }
+   }
+   return statement.size();
+}
+
+// Highest $n placeholder, which is what the server infers the parameter count from
+size_t placeholderCount(const Statement& statement) {
+   size_t count = 0;
+   for (const auto& token : statement) {
+      if (token.kind == 'w' && token.text.size() > 1 && token.text[0] == '$') {
+         count = std::max<size_t>(count, std::strtoul(token.text.c_str() + 1, nullptr, 10));
+      }
+   }
+   return count;
+}
+
+// Number of parenthesised rows after VALUES in an INSERT
+size_t valuesTuples(const Statement& statement) {
+   size_t tuples = 0;
+   int    depth  = 0;
+   for (size_t i = find(statement, "VALUES"); i < statement.size(); ++i) {
+      const auto& token = statement[i];
+      if (depth == 0 && (is(token, "RETURNING") || is(token, "ON"))) {
+         break;
+      }
+      if (token.kind == 'p' && token.text == "(") {
+         tuples += depth++ == 0 ? 1 : 0;
+      } else if (token.kind == 'p' && token.text == ")") {
+         --depth;
+      }
+   }
+   return std::max<size_t>(tuples, 1);
+}
+
+struct Field {
+   std::string name;
+   int32_t     oid;
+};
+
+struct PreparedStatement {
+   Statement            statement;
+   std::vector<int32_t> param_oids;
+};
+
+class Session {
+ public:
+   Session(FakePgServer& server, int fd)
+       : server(server), opts(server.options()), fd(fd), rng(static_cast<uint32_t>(fd) * 2654435761u) {
+      std::string value(opts.value_bytes, 'x');
+      for (size_t i = 0; i < value.size(); ++i) {
+         value[i] = static_cast<char>('a' + i % 26);
+      }
+      for (size_t c = 1; c < std::max<size_t>(opts.columns, 1); ++c) {
+         appendInt32(row_tail, static_cast<int32_t>(value.size()));
+         row_tail += value;
+         copy_tail += '\t' + value;
+      }
+   }
+
+   void run() {
+      if (!startup()) {
+         return;
+      }
+      std::string payload;
+      for (char type; readMessage(type, payload);) {
+         if (skipping && type != 'S') { // after an error the rest of the extended batch is ignored
+            continue;
+         }
+         switch (type) {
+            case 'Q':
+               simpleQuery(payload);
+               break;
+            case 'P':
+               parse(payload);
+               break;
+            case 'B':
+               bind(payload);
+               break;
+            case 'D':
+               describe(payload);
+               break;
+            case 'E':
+               executePortal(payload);
+               break;
+            case 'C':
+               close(payload);
+               break;
+            case 'S':
+               skipping = false;
+               readyForQuery();
+               break;
+            case 'H':
+               flush();
+               break;
+            case 'd':
+            case 'c':
+            case 'f':
+               break; // COPY traffic after the COPY already failed
+            case 'X':
+               return;
+            default:
+               writeError("08P01", std::string("unsupported frontend message type '") + type + "'");
+               flush();
+               return;
+         }
+      }
+   }
+
+ private:
+   /* <-------------------------------- Wire I/O -------------------------------->*/
+
+   bool readExact(char* data, size_t size) {
+      while (size > 0) {
+         ssize_t got = ::recv(fd, data, size, 0);
+         if (got < 0 && errno == EINTR) {
+            continue;
+         }
+         if (got <= 0) {
+            return false;
+         }
+         data += got;
+         size -= static_cast<size_t>(got);
+      }
+      return true;
+   }
+
+   bool readMessage(char& type, std::string& payload) {
+      char header[5];
+      if (!readExact(header, sizeof header)) {
+         return false;
+      }
+      type        = header[0];
+      int32_t len = readInt32(header + 1);
+      if (len < 4 || len > (1 << 30)) {
+         throw ProtocolError("bad message length");
+      }
+      payload.resize(static_cast<size_t>(len) - 4);
+      return readExact(payload.data(), payload.size());
+   }
+
+   void flush() {
+      size_t sent = 0;
+      while (sent < out.size()) {
+         ssize_t n = ::send(fd, out.data() + sent, out.size() - sent, kSendFlags);
+         if (n < 0 && errno == EINTR) {
+            continue;
+         }
+         if (n <= 0) {
+            throw ProtocolError("client went away");
+         }
+         sent += static_cast<size_t>(n);
+      }
+      out.clear();
+   }
+
+   static int32_t readInt32(const char* data) {
+      uint32_t value;
+      std::memcpy(&value, data, sizeof value);
+      return static_cast<int32_t>(ntohl(value));
+   }
+   static void appendInt32(std::string& buffer, int32_t value) {
+      uint32_t wire = htonl(static_cast<uint32_t>(value));
+      buffer.append(reinterpret_cast<const char*>(&wire), sizeof wire);
+   }
+   static void appendInt16(std::string& buffer, int16_t value) {
+      uint16_t wire = htons(static_cast<uint16_t>(value));
+      buffer.append(reinterpret_cast<const char*>(&wire), sizeof wire);
+   }
+
+   // Messages are built in place: begin() writes the type and a length placeholder, end() patches it
+   void begin(char type) {
+      out += type;
+      message_start = out.size();
+      out.append(4, '\0');
+   }
+   void end() {
+      uint32_t wire = htonl(static_cast<uint32_t>(out.size() - message_start));
+      std::memcpy(&out[message_start], &wire, sizeof wire);
+      if (out.size() >= kFlushAt) {
+         flush();
+      }
+   }
+   void putString(const std::string& text) {
+      out += text;
+      out += '\0';
+   }
+
+   // Cursor over a received payload; running off the end is a protocol error
+   struct Reader {
+      const std::string& data;
+      size_t             pos = 0;
+
+      int32_t int32() {
+         need(4);
+         pos += 4;
+         return readInt32(data.data() + pos - 4);
+      }
+      int16_t int16() {
+         need(2);
+         uint16_t value;
+         std::memcpy(&value, data.data() + pos, sizeof value);
+         pos += 2;
+         return static_cast<int16_t>(ntohs(value));
+      }
+      char byte() {
+         need(1);
+         return data[pos++];
+      }
+      std::string cstring() {
+         size_t end = data.find('\0', pos);
+         if (end == std::string::npos) {
+            throw ProtocolError("unterminated string in message");
+         }
+         std::string text = data.substr(pos, end - pos);
+         pos              = end + 1;
+         return text;
+      }
+      void skip(size_t size) {
+         need(size);
+         pos += size;
+      }
+      void need(size_t size) const {
+         if (data.size() - pos < size) {
+            throw ProtocolError("truncated message");
+         }
+      }
+   };
+
+   /* <-------------------------------- Messages -------------------------------->*/
+
+   bool startup() {
+      for (;;) {
+         char header[4];
+         if (!readExact(header, sizeof header)) {
+            return false;
+         }
+         int32_t len = readInt32(header);
+         if (len < 8 || len > 10000) {
+            return false;
+         }
+         std::string payload(static_cast<size_t>(len) - 4, '\0');
+         if (!readExact(payload.data(), payload.size())) {
+            return false;
+         }
+         Reader  reader{payload};
+         int32_t code = reader.int32();
+         if (code == kSslRequest || code == kGssEncRequest) {
+            out += 'N'; // no encryption here, the client carries on in plain text
+            flush();
+            continue;
+         }
+         if (code == kCancelRequest) {
+            return false; // nothing runs long enough here to be worth cancelling
+         }
+         if (code != kProtocolV3) {
+            writeError("0A000", "unsupported frontend protocol");
+            flush();
+            return false;
+         }
+
+         std::map<std::string, std::string> params;
+         for (std::string key; !(key = reader.cstring()).empty();) {
+            params[key] = reader.cstring();
+         }
+         if (opts.connect_latency.count() > 0) {
+            std::this_thread::sleep_for(opts.connect_latency);
+         }
+
+         begin('R');
+         appendInt32(out, 0); // AuthenticationOk: trust
+         end();
+         const std::pair<const char*, std::string> status[] = {
+             {"server_version", "16.0"},
+             {"server_encoding", "UTF8"},
+             {"client_encoding", "UTF8"},
+             {"DateStyle", "ISO, MDY"},
+             {"integer_datetimes", "on"},
+             {"standard_conforming_strings", "on"},
+             {"TimeZone", "UTC"},
+             {"is_superuser", "off"},
+             {"application_name", params["application_name"]},
+             {"session_authorization", params["user"]},
+         };
+         for (const auto& [name, value] : status) {
+            begin('S');
+            putString(name);
+            putString(value);
+            end();
+         }
+         begin('K');
+         appendInt32(out, fd);
+         appendInt32(out, static_cast<int32_t>(rng()));
+         end();
+         readyForQuery();
+         return true;
+      }
+   }
+
+   void readyForQuery() {
+      begin('Z');
+      out += txn_status;
+      end();
+      flush();
+   }
+
+   void writeError(const char* sqlstate, const std::string& message) {
+      begin('E');
+      out += 'S';
+      putString("ERROR");
+      out += 'V';
+      putString("ERROR");
+      out += 'C';
+      putString(sqlstate);
+      out += 'M';
+      putString(message);
+      out += '\0';
+      end();
+      if (txn_status == 'T') {
+         txn_status = 'E';
+      }
+      server.countError();
+   }
+
+   void commandComplete(const std::string& tag) {
+      begin('C');
+      putString(tag);
+      end();
+   }
+
+   void simpleQuery(const std::string& payload) {
+      Reader reader{payload};
+      auto   statements = splitStatements(reader.cstring());
+      if (statements.empty()) {
+         begin('I'); // EmptyQueryResponse
+         end();
+      }
+      for (const auto& statement : statements) {
+         if (!execute(statement, true)) {
+            break; // the rest of a multi-statement query is skipped after an error
+         }
+      }
+      readyForQuery();
+   }
+
+   void parse(const std::string& payload) {
+      Reader            reader{payload};
+      std::string       name = reader.cstring();
+      PreparedStatement prepared;
+      auto              statements = splitStatements(reader.cstring());
+      if (statements.size() > 1) {
+         failExtended("42601", "cannot insert multiple commands into a prepared statement");
+         return;
+      }
+      if (!statements.empty()) {
+         prepared.statement = std::move(statements.front());
+      }
+      int16_t count = reader.int16();
+      for (int16_t i = 0; i < count; ++i) {
+         prepared.param_oids.push_back(reader.int32());
+      }
+      prepared.param_oids.resize(std::max(prepared.param_oids.size(), placeholderCount(prepared.statement)), 0);
+      prepared_statements[name] = std::move(prepared);
+      begin('1'); // ParseComplete
+      end();
+   }
+
+   void bind(const std::string& payload) {
+      Reader      reader{payload};
+      std::string portal = reader.cstring();
+      std::string name   = reader.cstring();
+      auto        it     = prepared_statements.find(name);
+      if (it == prepared_statements.end()) {
+         failExtended("26000", "prepared statement \"" + name + "\" does not exist");
+         return;
+      }
+      reader.skip(2 * static_cast<size_t>(std::max<int16_t>(reader.int16(), 0))); // parameter format codes
+      int16_t values = reader.int16();
+      if (static_cast<size_t>(std::max<int16_t>(values, 0)) != it->second.param_oids.size()) {
+         failExtended("08P01", "bind message supplies " + std::to_string(values) + " parameters, but statement \"" +
+                                   name + "\" requires " + std::to_string(it->second.param_oids.size()));
+         return;
+      }
+      for (int16_t i = 0; i < values; ++i) {
+         int32_t len = reader.int32();
+         reader.skip(len > 0 ? static_cast<size_t>(len) : 0); // values don't change the synthetic reply
+      }
+      portals[portal] = it->second.statement;
+      begin('2'); // BindComplete
+      end();
+   }
+
+   void describe(const std::string& payload) {
+      Reader      reader{payload};
+      char        what = reader.byte();
+      std::string name = reader.cstring();
+      if (what == 'S') {
+         auto it = prepared_statements.find(name);
+         if (it == prepared_statements.end()) {
+            failExtended("26000", "prepared statement \"" + name + "\" does not exist");
+            return;
+         }
+         begin('t'); // ParameterDescription
+         appendInt16(out, static_cast<int16_t>(it->second.param_oids.size()));
+         for (int32_t oid : it->second.param_oids) {
+            appendInt32(out, oid == 0 ? kTextOid : oid);
+         }
+         end();
+         writeDescription(fieldsOf(it->second.statement));
+         return;
+      }
+      auto it = portals.find(name);
+      if (it == portals.end()) {
+         failExtended("34000", "portal \"" + name + "\" does not exist");
+         return;
+      }
+      writeDescription(fieldsOf(it->second));
+   }
+
+   void executePortal(const std::string& payload) {
+      Reader      reader{payload};
+      std::string name = reader.cstring();
+      auto        it   = portals.find(name);
+      if (it == portals.end()) {
+         failExtended("34000", "portal \"" + name + "\" does not exist");
+         return;
+      }
+      if (it->second.empty()) {
+         begin('I');
+         end();
+      } else if (!execute(it->second, false)) {
+         skipping = true;
+      }
+   }
+
+   void close(const std::string& payload) {
+      Reader      reader{payload};
+      char        what = reader.byte();
+      std::string name = reader.cstring();
+      if (what == 'S') {
+         prepared_statements.erase(name);
+      } else {
+         portals.erase(name);
+      }
+      begin('3'); // CloseComplete
+      end();
+   }
+
+   void failExtended(const char* sqlstate, const std::string& message) {
+      writeError(sqlstate, message);
+      skipping = true;
+   }
+
+   /* <-------------------------------- Statements -------------------------------->*/
+
+   std::vector<Field> syntheticFields() const {
+      std::vector<Field> fields{{"id", kInt4Oid}};
+      for (size_t c = 1; c < std::max<size_t>(opts.columns, 1); ++c) {
+         fields.push_back({"col" + std::to_string(c), kTextOid});
+      }
+      return fields;
+   }
+
+   static bool isLiteralSelect(const Statement& statement) {
+      return statement.size() == 2 && is(statement[0], "SELECT") &&
+             (statement[1].kind == 's' || isNumber(statement[1]));
+   }
+
+   // SELECT version(), which DatabaseManager::testConnection() runs on connect
+   static bool isVersionSelect(const Statement& statement) {
+      return statement.size() == 4 && is(statement[0], "SELECT") && is(statement[1], "VERSION") &&
+             statement[2].text == "(" && statement[3].text == ")";
+   }
+
+   // Columns a statement returns, empty if it returns none; the same answer Describe and Execute give
+   std::vector<Field> fieldsOf(const Statement& statement) const {
+      if (statement.empty()) {
+         return {};
+      }
+      const auto& verb = statement[0];
+      if (isLiteralSelect(statement)) {
+         return {{"?column?", statement[1].kind == 's' ? kTextOid : kInt4Oid}};
+      }
+      if (isVersionSelect(statement)) {
+         return {{"version", kTextOid}};
+      }
+      if (is(verb, "SELECT") || is(verb, "WITH") || is(verb, "VALUES") || is(verb, "TABLE") || is(verb, "FETCH")) {
+         return syntheticFields();
+      }
+      if (is(verb, "SHOW") && statement.size() > 1) {
+         return {{statement[1].text, kTextOid}};
+      }
+      if ((is(verb, "INSERT") || is(verb, "UPDATE") || is(verb, "DELETE")) &&
+          find(statement, "RETURNING") < statement.size()) {
+         return {{"id", kInt4Oid}};
+      }
+      return {};
+   }
+
+   void writeDescription(const std::vector<Field>& fields) {
+      if (fields.empty()) {
+         begin('n'); // NoData
+         end();
+         return;
+      }
+      begin('T');
+      appendInt16(out, static_cast<int16_t>(fields.size()));
+      for (const auto& field : fields) {
+         putString(field.name);
+         appendInt32(out, 0); // table oid
+         appendInt16(out, 0); // column number
+         appendInt32(out, field.oid);
+         appendInt16(out, field.oid == kInt4Oid ? 4 : -1);
+         appendInt32(out, -1); // typmod
+         appendInt16(out, 0);  // text format
+      }
+      end();
+   }
+
+   void writeValueRow(const std::string& value) {
+      begin('D');
+      appendInt16(out, 1);
+      appendInt32(out, static_cast<int32_t>(value.size()));
+      out += value;
+      end();
+   }
+
+   void writeSyntheticRows(size_t count, int64_t first_id) {
+      auto columns = static_cast<int16_t>(std::max<size_t>(opts.columns, 1));
+      for (size_t r = 0; r < count; ++r) {
+         std::string id = std::to_string(first_id + static_cast<int64_t>(r));
+         begin('D');
+         appendInt16(out, columns);
+         appendInt32(out, static_cast<int32_t>(id.size()));
+         out += id;
+         out += row_tail;
+         end();
+      }
+   }
+
+   size_t selectRows(const Statement& statement) const {
+      size_t limit = find(statement, "LIMIT");
+      if (limit + 1 < statement.size() && isNumber(statement[limit + 1])) {
+         return std::min<size_t>(opts.rows, std::stoul(statement[limit + 1].text));
+      }
+      return opts.rows;
+   }
+
+   void delay() {
+      auto pause = opts.latency;
+      if (opts.jitter.count() > 0) {
+         std::exponential_distribution<double> extra(1.0 / static_cast<double>(opts.jitter.count()));
+         pause += std::chrono::microseconds(static_cast<int64_t>(extra(rng)));
+      }
+      if (pause.count() > 0) {
+         std::this_thread::sleep_for(pause);
+      }
+   }
+
+   // Runs one statement and writes its reply. Returns false after writing an ErrorResponse.
+   bool execute(const Statement& statement, bool describe) {
+      delay();
+      const auto& verb    = statement[0];
+      bool        control = is(verb, "BEGIN") || is(verb, "START") || is(verb, "COMMIT") || is(verb, "END") ||
+                     is(verb, "ROLLBACK") || is(verb, "SAVEPOINT") || is(verb, "RELEASE");
+      if (txn_status == 'E' && !is(verb, "ROLLBACK") && !is(verb, "COMMIT") && !is(verb, "END")) {
+         writeError("25P02", "current transaction is aborted, commands ignored until end of transaction block");
+         return false;
+      }
+      if (!control && opts.error_rate > 0 && std::uniform_real_distribution<double>(0, 1)(rng) < opts.error_rate) {
+         writeError("XX000", "injected failure");
+         return false;
+      }
+
+      if (is(verb, "FETCH") || is(verb, "MOVE")) {
+         return fetch(statement, describe);
+      }
+      auto fields = fieldsOf(statement);
+      if (describe && !fields.empty()) {
+         writeDescription(fields);
+      }
+      uint64_t sent = 0;
+
+      if (is(verb, "BEGIN") || is(verb, "START")) {
+         txn_status = 'T';
+         commandComplete(is(verb, "BEGIN") ? "BEGIN" : "START TRANSACTION");
+      } else if (is(verb, "COMMIT") || is(verb, "END")) {
+         commandComplete(txn_status == 'E' ? "ROLLBACK" : "COMMIT");
+         endTransaction();
+      } else if (is(verb, "ROLLBACK")) {
+         if (statement.size() > 1 && is(statement[1], "TO")) {
+            txn_status = 'T'; // back at the savepoint, the transaction is usable again
+         } else {
+            endTransaction();
+         }
+         commandComplete("ROLLBACK");
+      } else if (isLiteralSelect(statement)) {
+         writeValueRow(statement[1].text);
+         sent = 1;
+         commandComplete("SELECT 1");
+      } else if (isVersionSelect(statement)) {
+         writeValueRow("PostgreSQL 16.0 (pgpool fake server)");
+         sent = 1;
+         commandComplete("SELECT 1");
+      } else if (is(verb, "SELECT") || is(verb, "WITH") || is(verb, "VALUES") || is(verb, "TABLE")) {
+         sent = selectRows(statement);
+         writeSyntheticRows(sent, 1);
+         commandComplete("SELECT " + std::to_string(sent));
+      } else if (is(verb, "SHOW")) {
+         writeValueRow("on");
+         sent = 1;
+         commandComplete("SHOW");
+      } else if (is(verb, "INSERT")) {
+         size_t rows = valuesTuples(statement);
+         if (!fields.empty()) {
+            for (size_t r = 0; r < rows; ++r) {
+               writeValueRow(std::to_string(server.nextId()));
+            }
+            sent = rows;
+         }
+         commandComplete("INSERT 0 " + std::to_string(rows));
+      } else if (is(verb, "UPDATE") || is(verb, "DELETE")) {
+         if (!fields.empty()) {
+            for (size_t r = 0; r < opts.update_rows; ++r) {
+               writeValueRow(std::to_string(r + 1));
+            }
+            sent = opts.update_rows;
+         }
+         commandComplete(upper(verb.text) + " " + std::to_string(opts.update_rows));
+      } else if (is(verb, "COPY")) {
+         if (find(statement, "STDIN") < statement.size()) {
+            return copyIn(statement);
+         }
+         sent = opts.rows;
+         copyOut(sent);
+      } else if (is(verb, "DECLARE")) {
+         if (statement.size() < 2) {
+            writeError("42601", "syntax error at or near \"DECLARE\"");
+            return false;
+         }
+         size_t body = find(statement, "FOR");
+         cursors[statement[1].text] = {selectRows(Statement(statement.begin() + std::min(body, statement.size()),
+                                                            statement.end())),
+                                       0};
+         commandComplete("DECLARE CURSOR");
+      } else if (is(verb, "CLOSE")) {
+         if (statement.size() > 1 && is(statement[1], "ALL")) {
+            cursors.clear();
+            commandComplete("CLOSE CURSOR ALL");
+         } else {
+            cursors.erase(statement.size() > 1 ? statement[1].text : "");
+            commandComplete("CLOSE CURSOR");
+         }
+      } else if ((is(verb, "CREATE") || is(verb, "DROP") || is(verb, "ALTER")) && statement.size() > 1) {
+         commandComplete(upper(verb.text) + " " + upper(statement[1].text));
+      } else {
+         commandComplete(upper(verb.text)); // SET, LISTEN, SAVEPOINT, RELEASE, DEALLOCATE, ...
+      }
+      server.countStatement(sent);
+      return true;
+   }
+
+   void endTransaction() {
+      txn_status = 'I';
+      cursors.clear(); // cursors without HOLD die with their transaction
+   }
+
+   // FETCH/MOVE [FORWARD | NEXT] [n | ALL] [FROM | IN] cursor
+   bool fetch(const Statement& statement, bool describe) {
+      size_t i = 1;
+      if (i < statement.size() && (is(statement[i], "FORWARD") || is(statement[i], "NEXT"))) {
+         ++i;
+      }
+      size_t wanted = 1;
+      if (i < statement.size() && isNumber(statement[i])) {
+         wanted = std::stoul(statement[i++].text);
+      } else if (i < statement.size() && is(statement[i], "ALL")) {
+         wanted = SIZE_MAX;
+         ++i;
+      }
+      if (i < statement.size() && (is(statement[i], "FROM") || is(statement[i], "IN"))) {
+         ++i;
+      }
+      std::string name = i < statement.size() ? statement[i].text : "";
+      auto        it   = cursors.find(name);
+      if (it == cursors.end()) {
+         writeError("34000", "cursor \"" + name + "\" does not exist");
+         return false;
+      }
+      auto& [total, delivered] = it->second;
+      size_t count             = std::min(wanted, total - delivered);
+      bool   move              = is(statement[0], "MOVE");
+      if (!move) {
+         if (describe) {
+            writeDescription(syntheticFields());
+         }
+         writeSyntheticRows(count, static_cast<int64_t>(delivered) + 1);
+      }
+      delivered += count;
+      commandComplete((move ? "MOVE " : "FETCH ") + std::to_string(count));
+      server.countStatement(move ? 0 : count);
+      return true;
+   }
+
+   bool copyIn(const Statement& statement) {
+      int16_t columns = static_cast<int16_t>(std::max<size_t>(opts.columns, 1));
+      size_t  open    = std::find_if(statement.begin(), statement.end(),
+                                     [](const Token& t) { return t.kind == 'p' && t.text == "("; }) -
+                    statement.begin();
+      if (open < statement.size()) {
+         columns = 1;
+         for (size_t i = open + 1; i < statement.size() && statement[i].text != ")"; ++i) {
+            columns += statement[i].kind == 'p' && statement[i].text == "," ? 1 : 0;
+         }
+      }
+      begin('G'); // CopyInResponse
+      out += '\0'; // text format
+      appendInt16(out, columns);
+      for (int16_t c = 0; c < columns; ++c) {
+         appendInt16(out, 0);
+      }
+      end();
+      flush();
+
+      uint64_t    rows = 0;
+      std::string payload;
+      for (char type; readMessage(type, payload);) {
+         if (type == 'd') {
+            rows += static_cast<uint64_t>(std::count(payload.begin(), payload.end(), '\n'));
+         } else if (type == 'c') {
+            server.countCopied(rows);
+            commandComplete("COPY " + std::to_string(rows));
+            server.countStatement(0);
+            return true;
+         } else if (type == 'f') {
+            writeError("57014", "COPY from stdin failed: " + Reader{payload}.cstring());
+            return false;
+         } else if (type != 'H' && type != 'S') {
+            writeError("08P01", std::string("unexpected message type '") + type + "' during COPY from stdin");
+            return false;
+         }
+      }
+      throw ProtocolError("client went away during COPY");
+   }
+
+   void copyOut(size_t rows) {
+      int16_t columns = static_cast<int16_t>(std::max<size_t>(opts.columns, 1));
+      begin('H'); // CopyOutResponse
+      out += '\0';
+      appendInt16(out, columns);
+      for (int16_t c = 0; c < columns; ++c) {
+         appendInt16(out, 0);
+      }
+      end();
+      for (size_t r = 0; r < rows; ++r) {
+         begin('d');
+         out += std::to_string(r + 1);
+         out += copy_tail;
+         out += '\n';
+         end();
+      }
+      begin('c'); // CopyDone
+      end();
+      commandComplete("COPY " + std::to_string(rows));
+   }
+
+   FakePgServer&        server;
+   const FakePgOptions& opts;
+   const int            fd;
+   std::mt19937         rng;
+
+   std::string out; // pending bytes, flushed at ReadyForQuery, Flush, COPY and every kFlushAt
+   size_t      message_start = 0;
+   std::string row_tail;  // the text columns of every DataRow, pre-encoded
+   std::string copy_tail; // the same columns as a COPY text line
+   char        txn_status = 'I';
+   bool        skipping   = false; // extended-protocol error: drop messages until Sync
+
+   std::map<std::string, PreparedStatement>         prepared_statements;
+   std::map<std::string, Statement>                 portals;
+   std::map<std::string, std::pair<size_t, size_t>> cursors; // name -> {rows, rows delivered}
+};
+} // namespace
+
+FakePgServer::FakePgServer(FakePgOptions options) : opts(std::move(options)) {}
+
+FakePgServer::~FakePgServer() {
+   stop();
+}
+
+void FakePgServer::start() {
+   listen_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+   if (listen_fd < 0) {
+      throw std::runtime_error(std::string("Fake server socket: ") + std::strerror(errno));
+   }
+   int on = 1;
+   ::setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof on);
+
+   sockaddr_in addr{};
+   addr.sin_family = AF_INET;
+   addr.sin_port   = htons(opts.port);
+   if (::inet_pton(AF_INET, opts.host.c_str(), &addr.sin_addr) != 1) {
+      ::close(listen_fd);
+      listen_fd = -1;
+      throw std::runtime_error("Fake server: '" + opts.host + "' is not an IPv4 address");
+   }
+   socklen_t len = sizeof addr;
+   if (::bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof addr) != 0 || ::listen(listen_fd, 128) != 0 ||
+       ::getsockname(listen_fd, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+      std::string error = std::strerror(errno);
+      ::close(listen_fd);
+      listen_fd = -1;
+      throw std::runtime_error("Fake server on " + opts.host + ":" + std::to_string(opts.port) + ": " + error);
+   }
+   bound_port = ntohs(addr.sin_port);
+   listener   = std::thread(&FakePgServer::acceptLoop, this);
+}
+
+void FakePgServer::stop() {
+   if (stopping.exchange(true)) {
+      return;
+   }
+   if (listener.joinable()) {
+      listener.join();
+   }
+   if (listen_fd >= 0) {
+      ::close(listen_fd);
+      listen_fd = -1;
+   }
+   std::map<uint64_t, std::thread> joining;
+   {
+      std::lock_guard<std::mutex> lock(session_mutex);
+      for (int fd : session_fds) {
+         ::shutdown(fd, SHUT_RDWR); // wakes the session out of recv(); it closes the fd itself
+      }
+      joining.swap(sessions);
+      finished.clear();
+   }
+   for (auto& [id, session] : joining) {
+      session.join();
+   }
+}
+
+// Joins the threads of sessions that have ended, so a long run with connection churn doesn't pile up
+// exited-but-unjoined threads and their stacks
+void FakePgServer::reapFinished() {
+   std::vector<std::thread> done;
+   {
+      std::lock_guard<std::mutex> lock(session_mutex);
+      for (uint64_t id : finished) {
+         auto it = sessions.find(id);
+         done.push_back(std::move(it->second));
+         sessions.erase(it);
+      }
+      finished.clear();
+   }
+   for (auto& session : done) {
+      session.join(); // already past its last statement, so this doesn't block
+   }
+}
+
+// Polls instead of blocking in accept() so stop() only has to flip `stopping`
+void FakePgServer::acceptLoop() {
+   while (!stopping.load()) {
+      reapFinished();
+      pollfd ready{listen_fd, POLLIN, 0};
+      if (::poll(&ready, 1, 100) <= 0) {
+         continue;
+      }
+      int fd = ::accept(listen_fd, nullptr, nullptr);
+      if (fd < 0) {
+         continue;
+      }
+      int on = 1;
+      ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof on); // replies are small and latency is the point
+#ifdef SO_NOSIGPIPE
+      ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof on);
+#endif
+      std::lock_guard<std::mutex> lock(session_mutex);
+      session_fds.push_back(fd);
+      uint64_t id = next_session++;
+      sessions.emplace(id, std::thread(&FakePgServer::serve, this, id, fd));
+   }
+}
+
+void FakePgServer::serve(uint64_t id, int fd) {
+   connections.fetch_add(1, std::memory_order_relaxed);
+   try {
+      Session(*this, fd).run();
+   } catch (const std::exception& e) {
+      if (!stopping.load()) {
+         std::cerr << "Fake server session: " << e.what() << std::endl;
+      }
+   }
+   std::lock_guard<std::mutex> lock(session_mutex);
+   session_fds.erase(std::find(session_fds.begin(), session_fds.end(), fd));
+   ::close(fd);
+   if (!stopping.load()) {
+      finished.push_back(id); // stop() joins everything itself
+   }
+}
+
+uint16_t FakePgServer::port() const {
+   return bound_port;
+}
+
+std::string FakePgServer::connectionString() const {
+   return "host=" + opts.host + " port=" + std::to_string(bound_port) +
+          " dbname=pgpool user=pgpool sslmode=disable gssencmode=disable";
+}
+
+FakePgServer::Stats FakePgServer::stats() const {
+   Stats snap;
+   snap.connections = connections.load(std::memory_order_relaxed);
+   snap.statements  = statements.load(std::memory_order_relaxed);
+   snap.rows_sent   = rows_sent.load(std::memory_order_relaxed);
+   snap.rows_copied = rows_copied.load(std::memory_order_relaxed);
+   snap.errors      = errors.load(std::memory_order_relaxed);
+   return snap;
+}
+
+void FakePgServer::countStatement(uint64_t rows) {
+   statements.fetch_add(1, std::memory_order_relaxed);
+   rows_sent.fetch_add(rows, std::memory_order_relaxed);
+}
+
+void FakePgServer::countCopied(uint64_t rows) {
+   rows_copied.fetch_add(rows, std::memory_order_relaxed);
+}
+
+void FakePgServer::countError() {
+   errors.fetch_add(1, std::memory_order_relaxed);
+}
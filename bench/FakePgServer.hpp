@@ -0,0 +1,101 @@
+// Copyright (c) 2025 Tanner Davison. All Rights Reserved.
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct FakePgOptions {
+   std::string host = "127.0.0.1";
+   uint16_t    port = 0; // 0 picks a free port, see FakePgServer::port()
+
+   // Shape of the synthetic result a SELECT gets: an int4 "id" column followed by text columns.
+   // A LIMIT in the query caps the row count.
+   size_t rows        = 100;
+   size_t columns     = 4;
+   size_t value_bytes = 16; // width of each text value
+   size_t update_rows = 1;  // rows an UPDATE or DELETE reports as affected
+
+   // Injected per statement: a fixed delay plus an exponentially distributed extra with mean `jitter`
+   std::chrono::microseconds latency{0};
+   std::chrono::microseconds jitter{0};
+   std::chrono::microseconds connect_latency{0}; // before the startup reply, to mimic a handshake
+   double                    error_rate = 0;     // fraction of statements answered with an ErrorResponse
+};
+
+/**
+ * FakePgServer
+ *   ├─[owns]→ listener thread    (accepts on host:port, polls so stop() never waits on accept())
+ *   └─[owns]→ one thread per client session, joined by the listener once the client disconnects
+ *                └─ speaks protocol v3: startup with trust auth, simple query (several statements per
+ *                   message), extended query (Parse/Bind/Describe/Execute/Sync/Close/Flush), COPY FROM
+ *                   STDIN and COPY TO STDOUT
+ *
+ * Nothing is stored. Every statement is answered from its leading keyword: SELECTs get the synthetic
+ * result described by FakePgOptions, INSERT ... RETURNING gets fresh ids, cursors hand out their rows
+ * across FETCHes, and BEGIN/COMMIT/ROLLBACK/SAVEPOINT move the transaction status libpq tracks.
+ * That is enough for the pool, QueryExecutor and DataModifier paths to run against it unmodified.
+ */
+class FakePgServer {
+ public:
+   struct Stats {
+      uint64_t connections = 0;
+      uint64_t statements  = 0;
+      uint64_t rows_sent   = 0;
+      uint64_t rows_copied = 0; // received through COPY FROM STDIN
+      uint64_t errors      = 0; // injected errors included
+   };
+
+   explicit FakePgServer(FakePgOptions options = {});
+   ~FakePgServer(); // stops the server
+
+   void start(); // binds and starts accepting; throws std::runtime_error if the socket can't be set up
+   void stop();  // closes the listener and every session, then joins all threads
+
+   uint16_t    port() const;
+   std::string connectionString() const; // libpq keyword/value string for this server
+   Stats       stats() const;
+
+   // Used by the session threads
+   const FakePgOptions& options() const {
+      return opts;
+   }
+   int32_t nextId() {
+      return next_id.fetch_add(1, std::memory_order_relaxed);
+   }
+   void countStatement(uint64_t rows_sent);
+   void countCopied(uint64_t rows);
+   void countError();
+
+   FakePgServer(const FakePgServer&)            = delete;
+   FakePgServer& operator=(const FakePgServer&) = delete;
+
+ private:
+   void acceptLoop();
+   void reapFinished();
+   void serve(uint64_t id, int fd);
+
+   const FakePgOptions opts;
+   int                 listen_fd  = -1;
+   uint16_t            bound_port = 0;
+   std::atomic<bool>   stopping{false};
+   std::thread         listener;
+
+   std::mutex                      session_mutex; // guards sessions, finished, session_fds and next_session
+   std::map<uint64_t, std::thread> sessions;      // by session id; fds get reused, ids don't
+   std::vector<uint64_t>           finished;      // sessions whose thread is done, joined by the listener
+   std::vector<int>                session_fds;   // open client sockets, shut down by stop()
+   uint64_t                        next_session = 0;
+
+   std::atomic<int32_t>  next_id{1};
+   std::atomic<uint64_t> connections{0};
+   std::atomic<uint64_t> statements{0};
+   std::atomic<uint64_t> rows_sent{0};
+   std::atomic<uint64_t> rows_copied{0};
+   std::atomic<uint64_t> errors{0};
+};
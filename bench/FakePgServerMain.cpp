@@ -0,0 +1,86 @@
+// pgpool_fakepg: runs FakePgServer standalone until interrupted, for pointing the GUI or any libpq client at it.
+//
+//   pgpool_fakepg [--port 5433] [--host 127.0.0.1] [--rows 100] [--columns 4] [--value-bytes 16]
+//                 [--latency-us 0] [--jitter-us 0] [--connect-us 0] [--error-rate 0]
+
+#include "FakePgServer.hpp"
+
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace {
+volatile std::sig_atomic_t interrupted = 0;
+
+void onSignal(int) {
+   interrupted = 1;
+}
+
+FakePgOptions parseArgs(int argc, char* argv[]) {
+   FakePgOptions options;
+   options.port = 5433;
+   for (int i = 1; i < argc; ++i) {
+      std::string arg = argv[i];
+      if (arg == "--help" || arg == "-h") {
+         std::cout << "usage: pgpool_fakepg [--port 5433] [--host 127.0.0.1] [--rows 100] [--columns 4]\n"
+                      "                     [--value-bytes 16] [--latency-us 0] [--jitter-us 0] [--connect-us 0]\n"
+                      "                     [--error-rate 0]\n";
+         std::exit(0);
+      }
+      if (i + 1 >= argc) {
+         throw std::invalid_argument("Missing value for " + arg);
+      }
+      std::string value = argv[++i];
+      if (arg == "--port") {
+         options.port = static_cast<uint16_t>(std::stoul(value));
+      } else if (arg == "--host") {
+         options.host = value;
+      } else if (arg == "--rows") {
+         options.rows = std::stoul(value);
+      } else if (arg == "--columns") {
+         options.columns = std::stoul(value);
+      } else if (arg == "--value-bytes") {
+         options.value_bytes = std::stoul(value);
+      } else if (arg == "--latency-us") {
+         options.latency = std::chrono::microseconds(std::stoll(value));
+      } else if (arg == "--jitter-us") {
+         options.jitter = std::chrono::microseconds(std::stoll(value));
+      } else if (arg == "--connect-us") {
+         options.connect_latency = std::chrono::microseconds(std::stoll(value));
+      } else if (arg == "--error-rate") {
+         options.error_rate = std::stod(value);
+      } else {
+         throw std::invalid_argument("Unknown option " + arg);
+      }
+   }
+   return options;
+}
+} // namespace
+
+int main(int argc, char* argv[]) {
+   try {
+      FakePgServer server(parseArgs(argc, argv));
+      server.start();
+      std::signal(SIGINT, onSignal);
+      std::signal(SIGTERM, onSignal);
+      std::cout << "Fake PostgreSQL server listening: " << server.connectionString() << std::endl;
+
+      while (!interrupted) {
+         std::this_thread::sleep_for(std::chrono::milliseconds(200));
+      }
+      server.stop();
+
+      auto stats = server.stats();
+      std::cout << "\n" << stats.connections << " connections, " << stats.statements << " statements, "
+                << stats.rows_sent << " rows sent, " << stats.rows_copied << " rows copied in, " << stats.errors
+                << " errors" << std::endl;
+      return 0;
+   } catch (const std::exception& e) {
+      std::cerr << "pgpool_fakepg: " << e.what() << std::endl;
+      return 2;
+   }
+}
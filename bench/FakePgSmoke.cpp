@@ -0,0 +1,219 @@
+// pgpool_fakepg_smoke: drives an in-process FakePgServer through real libpq, one check per protocol feature.
+//
+//   pgpool_fakepg_smoke [--connections 200]
+//
+// Covers what the pool, QueryExecutor and DataModifier lean on: PQexec (single and multi-statement),
+// PQexecParams, PQprepare/PQdescribePrepared/PQexecPrepared, COPY FROM STDIN and TO STDOUT, cursors,
+// transactions with savepoints and the aborted state, pipeline mode, and a connect/disconnect churn.
+// Prints one line per check and exits non-zero if any failed.
+
+#include "FakePgServer.hpp"
+
+#include <libpq-fe.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+constexpr size_t kRows = 5; // rows every synthetic SELECT returns
+
+using Conn   = std::unique_ptr<PGconn, decltype(&PQfinish)>;
+using Result = std::unique_ptr<PGresult, decltype(&PQclear)>;
+
+struct CheckFailed : std::runtime_error {
+   using std::runtime_error::runtime_error;
+};
+
+void expect(bool condition, const std::string& what) {
+   if (!condition) {
+      throw CheckFailed(what);
+   }
+}
+
+Conn connect(const FakePgServer& server) {
+   Conn conn(PQconnectdb(server.connectionString().c_str()), &PQfinish);
+   expect(PQstatus(conn.get()) == CONNECTION_OK, std::string("connect: ") + PQerrorMessage(conn.get()));
+   return conn;
+}
+
+Result exec(PGconn* conn, const char* sql, ExecStatusType want) {
+   Result result(PQexec(conn, sql), &PQclear);
+   expect(PQresultStatus(result.get()) == want, std::string(sql) + ": got " +
+                                                    PQresStatus(PQresultStatus(result.get())) + " " +
+                                                    PQerrorMessage(conn));
+   return result;
+}
+
+// Pulls the next result of an async/pipelined call and checks its status
+Result next(PGconn* conn, ExecStatusType want, const std::string& what) {
+   Result result(PQgetResult(conn), &PQclear);
+   expect(result != nullptr, what + ": no result");
+   expect(PQresultStatus(result.get()) == want,
+          what + ": got " + PQresStatus(PQresultStatus(result.get())) + " " + PQerrorMessage(conn));
+   return result;
+}
+
+void simpleQuery(const FakePgServer& server) {
+   auto conn = connect(server);
+   expect(PQserverVersion(conn.get()) == 160000, "server_version is reported as 16.0");
+   auto version = exec(conn.get(), "SELECT version()", PGRES_TUPLES_OK);
+   expect(PQntuples(version.get()) == 1, "SELECT version() returns one row");
+
+   auto rows = exec(conn.get(), "SELECT * FROM t LIMIT 3", PGRES_TUPLES_OK);
+   expect(PQntuples(rows.get()) == 3 && PQnfields(rows.get()) == 3, "LIMIT 3 gives 3 rows of 3 columns");
+   expect(std::strcmp(PQfname(rows.get(), 0), "id") == 0, "first column is id");
+
+   auto last = exec(conn.get(), "SELECT 1; SELECT * FROM t; UPDATE t SET v = 'x;y'", PGRES_COMMAND_OK);
+   expect(std::strcmp(PQcmdTuples(last.get()), "1") == 0, "multi-statement PQexec returns the UPDATE's count");
+}
+
+void extendedQuery(const FakePgServer& server) {
+   auto        conn     = connect(server);
+   const char* values[] = {"hello"};
+   Result      inserted(PQexecParams(conn.get(), "INSERT INTO t (v) VALUES ($1) RETURNING id", 1, nullptr, values,
+                                     nullptr, nullptr, 0),
+                        &PQclear);
+   expect(PQresultStatus(inserted.get()) == PGRES_TUPLES_OK && PQntuples(inserted.get()) == 1,
+          "PQexecParams INSERT ... RETURNING gives one id");
+
+   Result prepared(PQprepare(conn.get(), "by_id", "SELECT * FROM t WHERE id = $1", 0, nullptr), &PQclear);
+   expect(PQresultStatus(prepared.get()) == PGRES_COMMAND_OK, "PQprepare");
+   Result described(PQdescribePrepared(conn.get(), "by_id"), &PQclear);
+   expect(PQresultStatus(described.get()) == PGRES_COMMAND_OK && PQnparams(described.get()) == 1 &&
+              PQnfields(described.get()) == 3,
+          "PQdescribePrepared reports 1 parameter and 3 columns");
+   const char* id[] = {"7"};
+   Result      selected(PQexecPrepared(conn.get(), "by_id", 1, id, nullptr, nullptr, 0), &PQclear);
+   expect(PQresultStatus(selected.get()) == PGRES_TUPLES_OK && PQntuples(selected.get()) == kRows,
+          "PQexecPrepared runs the statement");
+
+   Result wrong(PQexecPrepared(conn.get(), "by_id", 0, nullptr, nullptr, nullptr, 0), &PQclear);
+   expect(PQresultStatus(wrong.get()) == PGRES_FATAL_ERROR, "binding the wrong parameter count fails");
+   exec(conn.get(), "SELECT 1", PGRES_TUPLES_OK); // and the session recovers
+}
+
+void copy(const FakePgServer& server) {
+   auto conn   = connect(server);
+   auto before = server.stats().rows_copied;
+   exec(conn.get(), "COPY t (v) FROM STDIN", PGRES_COPY_IN);
+   for (const char* line : {"a\n", "b\n", "c\n"}) {
+      expect(PQputCopyData(conn.get(), line, static_cast<int>(std::strlen(line))) == 1, "PQputCopyData");
+   }
+   expect(PQputCopyEnd(conn.get(), nullptr) == 1, "PQputCopyEnd");
+   next(conn.get(), PGRES_COMMAND_OK, "COPY FROM STDIN");
+   expect(PQgetResult(conn.get()) == nullptr, "COPY FROM STDIN has one result");
+   expect(server.stats().rows_copied - before == 3, "the server counted 3 copied rows");
+
+   exec(conn.get(), "COPY t TO STDOUT", PGRES_COPY_OUT);
+   size_t lines = 0;
+   char*  buffer;
+   while (PQgetCopyData(conn.get(), &buffer, 0) > 0) {
+      ++lines;
+      PQfreemem(buffer);
+   }
+   expect(lines == kRows, "COPY TO STDOUT sends every row");
+   next(conn.get(), PGRES_COMMAND_OK, "COPY TO STDOUT");
+   expect(PQgetResult(conn.get()) == nullptr, "COPY TO STDOUT has one result");
+}
+
+void cursorsAndSavepoints(const FakePgServer& server) {
+   auto conn = connect(server);
+   exec(conn.get(), "BEGIN", PGRES_COMMAND_OK);
+   expect(PQtransactionStatus(conn.get()) == PQTRANS_INTRANS, "BEGIN opens a transaction");
+   exec(conn.get(), "DECLARE c NO SCROLL CURSOR FOR SELECT * FROM t", PGRES_COMMAND_OK);
+   auto first = exec(conn.get(), "FETCH FORWARD 2 FROM c", PGRES_TUPLES_OK);
+   auto rest  = exec(conn.get(), "FETCH FORWARD 100 FROM c", PGRES_TUPLES_OK);
+   auto none  = exec(conn.get(), "FETCH FORWARD 100 FROM c", PGRES_TUPLES_OK);
+   expect(PQntuples(first.get()) == 2 && PQntuples(rest.get()) == kRows - 2 && PQntuples(none.get()) == 0,
+          "FETCH pages through the cursor's rows once");
+   exec(conn.get(), "CLOSE c", PGRES_COMMAND_OK);
+
+   exec(conn.get(), "SAVEPOINT s", PGRES_COMMAND_OK);
+   exec(conn.get(), "FETCH 1 FROM missing", PGRES_FATAL_ERROR);
+   expect(PQtransactionStatus(conn.get()) == PQTRANS_INERROR, "an error aborts the transaction");
+   auto aborted = exec(conn.get(), "SELECT 1", PGRES_FATAL_ERROR);
+   expect(std::strcmp(PQresultErrorField(aborted.get(), PG_DIAG_SQLSTATE), "25P02") == 0,
+          "statements in an aborted transaction fail with 25P02");
+   exec(conn.get(), "ROLLBACK TO SAVEPOINT s", PGRES_COMMAND_OK);
+   expect(PQtransactionStatus(conn.get()) == PQTRANS_INTRANS, "ROLLBACK TO SAVEPOINT recovers");
+   exec(conn.get(), "COMMIT", PGRES_COMMAND_OK);
+   expect(PQtransactionStatus(conn.get()) == PQTRANS_IDLE, "COMMIT ends the transaction");
+}
+
+void pipeline(const FakePgServer& server) {
+   auto conn = connect(server);
+   expect(PQenterPipelineMode(conn.get()) == 1, "PQenterPipelineMode");
+   const char* values[] = {"1"};
+   for (int i = 0; i < 3; ++i) {
+      expect(PQsendQueryParams(conn.get(), "SELECT * FROM t WHERE id = $1", 1, nullptr, values, nullptr, nullptr,
+                               0) == 1,
+             "PQsendQueryParams in a pipeline");
+   }
+   expect(PQpipelineSync(conn.get()) == 1, "PQpipelineSync");
+   for (int i = 0; i < 3; ++i) {
+      auto rows = next(conn.get(), PGRES_TUPLES_OK, "pipelined SELECT");
+      expect(PQntuples(rows.get()) == kRows, "pipelined SELECT returns its rows");
+      expect(PQgetResult(conn.get()) == nullptr, "each pipelined query ends with a null result");
+   }
+   next(conn.get(), PGRES_PIPELINE_SYNC, "pipeline sync");
+   expect(PQexitPipelineMode(conn.get()) == 1, "PQexitPipelineMode");
+}
+
+void churn(const FakePgServer& server, size_t connections) {
+   for (size_t i = 0; i < connections; ++i) {
+      auto conn = connect(server);
+      exec(conn.get(), "SELECT 1", PGRES_TUPLES_OK);
+   }
+}
+} // namespace
+
+int main(int argc, char* argv[]) {
+   size_t connections = 200;
+   for (int i = 1; i < argc; ++i) {
+      std::string arg = argv[i];
+      if (arg == "--connections" && i + 1 < argc) {
+         connections = std::stoul(argv[++i]);
+      } else {
+         std::cout << "usage: pgpool_fakepg_smoke [--connections 200]\n";
+         return arg == "--help" || arg == "-h" ? 0 : 2;
+      }
+   }
+
+   FakePgOptions options;
+   options.rows    = kRows;
+   options.columns = 3;
+   FakePgServer server(options);
+   try {
+      server.start();
+   } catch (const std::exception& e) {
+      std::cerr << "pgpool_fakepg_smoke: " << e.what() << std::endl;
+      return 2;
+   }
+
+   const std::vector<std::pair<const char*, std::function<void()>>> checks = {
+       {"simple query", [&] { simpleQuery(server); }},
+       {"extended query", [&] { extendedQuery(server); }},
+       {"copy in/out", [&] { copy(server); }},
+       {"cursors and savepoints", [&] { cursorsAndSavepoints(server); }},
+       {"pipeline mode", [&] { pipeline(server); }},
+       {"connection churn", [&] { churn(server, connections); }},
+   };
+   int failed = 0;
+   for (const auto& [name, check] : checks) {
+      try {
+         check();
+         std::cout << "ok    " << name << std::endl;
+      } catch (const std::exception& e) {
+         ++failed;
+         std::cout << "FAIL  " << name << ": " << e.what() << std::endl;
+      }
+   }
+   server.stop();
+   return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,108 @@
+// Copyright (c) 2025 Tanner Davison. All Rights Reserved.
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+// Keeps a uniform sample of at most `capacity` latencies (reservoir sampling), so long runs don't grow
+// without bound. Count, sum and max cover every latency recorded, not just the kept ones. One per worker
+// thread; not thread-safe.
+class LatencySample {
+ public:
+   LatencySample(size_t capacity, uint32_t seed) : capacity(capacity), rng(seed) {}
+
+   void record(std::chrono::steady_clock::duration elapsed) {
+      auto ns = static_cast<uint64_t>(std::max<int64_t>(
+          0, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+      ++seen;
+      sum_ns += ns;
+      max_ns = std::max(max_ns, ns);
+      if (values.size() < capacity) {
+         values.push_back(ns);
+      } else {
+         uint64_t slot = std::uniform_int_distribution<uint64_t>(0, seen - 1)(rng);
+         if (slot < capacity) {
+            values[slot] = ns;
+         }
+      }
+   }
+
+   uint64_t recorded() const {
+      return seen;
+   }
+   // True once the reservoir overflowed, i.e. `values` is a sample rather than every latency
+   bool sampled() const {
+      return seen > values.size();
+   }
+
+   std::vector<uint64_t> values; // nanoseconds, in no particular order
+
+ private:
+   friend struct Percentiles;
+
+   size_t           capacity;
+   std::minstd_rand rng;
+   uint64_t         seen   = 0;
+   uint64_t         sum_ns = 0;
+   uint64_t         max_ns = 0;
+};
+
+struct Percentiles {
+   double mean = 0, p50 = 0, p95 = 0, p99 = 0, p999 = 0, max = 0; // microseconds
+
+   // Percentiles over several workers' samples. Each kept value stands for recorded() / values.size()
+   // latencies of its worker, so a busy worker whose reservoir overflowed isn't outweighed by idle ones.
+   // Exact as long as no reservoir overflowed (see LatencySample::sampled()); mean and max always are.
+   static Percentiles of(const std::vector<const LatencySample*>& samples) {
+      Percentiles                              out;
+      std::vector<std::pair<uint64_t, double>> weighted; // nanoseconds, latencies it stands for
+      uint64_t                                 count = 0;
+      double                                   sum   = 0;
+      uint64_t                                 max   = 0;
+      for (const LatencySample* sample : samples) {
+         if (sample->values.empty()) {
+            continue;
+         }
+         double weight = static_cast<double>(sample->seen) / static_cast<double>(sample->values.size());
+         for (uint64_t value : sample->values) {
+            weighted.emplace_back(value, weight);
+         }
+         count += sample->seen;
+         sum += static_cast<double>(sample->sum_ns);
+         max = std::max(max, sample->max_ns);
+      }
+      if (weighted.empty()) {
+         return out;
+      }
+      std::sort(weighted.begin(), weighted.end());
+
+      // Smallest value whose cumulative weight passes p of the total, which for equal weights is
+      // values[floor(p * n)]
+      double total = 0;
+      for (const auto& entry : weighted) {
+         total += entry.second;
+      }
+      auto at = [&](double p) {
+         double target     = p * total;
+         double cumulative = 0;
+         for (const auto& [value, weight] : weighted) {
+            cumulative += weight;
+            if (cumulative > target) {
+               return value / 1000.0;
+            }
+         }
+         return weighted.back().first / 1000.0;
+      };
+      out.mean = sum / static_cast<double>(count) / 1000.0;
+      out.p50  = at(0.50);
+      out.p95  = at(0.95);
+      out.p99  = at(0.99);
+      out.p999 = at(0.999);
+      out.max  = max / 1000.0;
+      return out;
+   }
+};
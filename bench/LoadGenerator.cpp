@@ -0,0 +1,553 @@
+// pgpool-load: pgbench-style load generator driving DatabaseManager, for sizing min/max_connections.
+//
+//   pgpool-load [--host localhost] [--port 5432] [--dbname tanner] [--user tanner] [--password ...]
+//               [--min-conns 2] [--max-conns 10] [--threads 8] [--duration 10] [--warmup 2] [--rate 0]
+//               [--mix select=80,insert=10,update=10] [--table pgpool_load] [--rows 10000] [--value-bytes 64]
+//               [--no-setup] [--json FILE|-] [--fake] [--fake-latency-us 0] [--fake-jitter-us 0]
+//               [--compare-reads]
+//
+// Each client thread picks an operation by the mix weights: selectPrepared() by id, insert() of one row,
+// or update() by id. With --rate 0 the threads run closed-loop, each starting its next operation when the
+// last one returns. With --rate R the threads together start R operations per second at Poisson arrivals,
+// and latency is measured from the scheduled start, so time spent queued behind a slow server counts.
+// Only operations scheduled after the warm-up are recorded. Percentiles are exact unless a thread records
+// more operations than its reservoir holds, which the report flags. Pool wait (getConnection until a handle
+// is granted) comes from the pool's own histogram and is reported separately; peak waiters is whole-run.
+//
+// --compare-reads replaces the mix with selectPrepared()'s point lookup run two ways, picked at random per
+// operation on one shared pool: inside pqxx::work (BEGIN, query, COMMIT, as selectPrepared() did before it
+// went autocommit) and inside pqxx::nontransaction (the query alone, as it runs now).
+//
+// Setup drops and recreates the table, then COPYs in --rows rows so ids 1..rows exist. --password
+// defaults to $PGPASSWORD. --fake runs against an in-process FakePgServer instead of --host/--port.
+
+#include "DatabaseManager.hpp"
+#include "LatencySample.hpp"
+#ifdef PGPOOL_HAVE_FAKEPG
+#include "FakePgServer.hpp"
+#endif
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+enum class OpKind : size_t { Select, Insert, Update, ReadWork, ReadNontx, Count };
+constexpr size_t kOpKinds                    = static_cast<size_t>(OpKind::Count);
+constexpr size_t kMixKinds                   = 3; // --mix sets these; the read_* kinds belong to --compare-reads
+const char*      kOpNames[kOpKinds]          = {"select", "insert", "update", "read_work", "read_nontx"};
+constexpr size_t kSamplesPerThreadAndKind    = 1 << 16; // closed loop, and the floor for open loop
+constexpr size_t kMaxSamplesPerThreadAndKind = 1 << 21; // 16 MiB of latencies
+
+struct Options {
+   std::string host     = "localhost";
+   int         port     = 5432;
+   std::string dbname   = "tanner";
+   std::string user     = "tanner";
+   std::string password = std::getenv("PGPASSWORD") ? std::getenv("PGPASSWORD") : "";
+
+   size_t min_connections = 2;
+   size_t max_connections = 10;
+
+   size_t                       threads  = 8;
+   double                       duration = 10; // seconds measured
+   double                       warmup   = 2;  // seconds run first and discarded
+   double                       rate     = 0;  // operations per second across all threads; 0 = closed loop
+   std::array<size_t, kOpKinds> mix      = {80, 10, 10, 0, 0};
+   bool                         compare_reads = false;
+
+   std::string table       = "pgpool_load";
+   size_t      rows        = 10000;
+   size_t      value_bytes = 64;
+   bool        setup       = true;
+   std::string json_path; // "-" prints the JSON report to stdout after the text one
+
+   bool    fake            = false;
+   int64_t fake_latency_us = 0;
+   int64_t fake_jitter_us  = 0;
+};
+
+struct OpStats {
+   uint64_t    ok      = 0;
+   uint64_t    errors  = 0;
+   bool        sampled = false; // some thread's reservoir overflowed, so percentiles are estimates
+   Percentiles latency;         // microseconds
+};
+
+struct PoolWait {
+   LatencyHistogram::Snapshot acquire_wait; // only the measured window
+   uint64_t                   exhaustion_events = 0;
+   uint64_t                   timeouts          = 0;
+   size_t                     peak_waiters      = 0; // whole run: the pool can't reset it at the window
+   size_t                     total_connections = 0;
+};
+
+struct Report {
+   std::array<OpStats, kOpKinds> ops;
+   OpStats                       total;
+   PoolWait                      pool;
+   double                        seconds = 0;
+};
+
+std::vector<std::string> splitList(const std::string& list) {
+   std::vector<std::string> items;
+   std::stringstream        stream(list);
+   for (std::string item; std::getline(stream, item, ',');) {
+      if (!item.empty()) {
+         items.push_back(item);
+      }
+   }
+   return items;
+}
+
+std::array<size_t, kOpKinds> parseMix(const std::string& spec) {
+   std::array<size_t, kOpKinds> mix{};
+   for (const auto& item : splitList(spec)) {
+      auto        equals = item.find('=');
+      std::string name   = item.substr(0, equals);
+      size_t      kind   = 0;
+      while (kind < kMixKinds && name != kOpNames[kind]) {
+         ++kind;
+      }
+      if (equals == std::string::npos || kind == kMixKinds) {
+         throw std::invalid_argument("Mix entries look like select=80, got '" + item + "'");
+      }
+      mix[kind] = std::stoul(item.substr(equals + 1));
+   }
+   if (mix[0] + mix[1] + mix[2] == 0) {
+      throw std::invalid_argument("The mix needs at least one non-zero weight");
+   }
+   return mix;
+}
+
+Options parseArgs(int argc, char* argv[]) {
+   Options options;
+   for (int i = 1; i < argc; ++i) {
+      std::string arg = argv[i];
+      if (arg == "--help" || arg == "-h") {
+         std::cout << "usage: pgpool-load [--host localhost] [--port 5432] [--dbname tanner] [--user tanner]\n"
+                      "                   [--password ...] [--min-conns 2] [--max-conns 10] [--threads 8]\n"
+                      "                   [--duration 10] [--warmup 2] [--rate 0]\n"
+                      "                   [--mix select=80,insert=10,update=10] [--table pgpool_load] [--rows 10000]\n"
+                      "                   [--value-bytes 64] [--no-setup]\n"
+                      "                   [--json FILE|-] [--fake] [--fake-latency-us 0] [--fake-jitter-us 0]\n"
+                      "                   [--compare-reads]\n";
+         std::exit(0);
+      }
+      if (arg == "--no-setup") {
+         options.setup = false;
+         continue;
+      }
+      if (arg == "--fake") {
+         options.fake = true;
+         continue;
+      }
+      if (arg == "--compare-reads") {
+         options.compare_reads = true;
+         continue;
+      }
+      if (i + 1 >= argc) {
+         throw std::invalid_argument("Missing value for " + arg);
+      }
+      std::string value = argv[++i];
+      if (arg == "--host") {
+         options.host = value;
+      } else if (arg == "--port") {
+         options.port = std::stoi(value);
+      } else if (arg == "--dbname") {
+         options.dbname = value;
+      } else if (arg == "--user") {
+         options.user = value;
+      } else if (arg == "--password") {
+         options.password = value;
+      } else if (arg == "--min-conns") {
+         options.min_connections = std::stoul(value);
+      } else if (arg == "--max-conns") {
+         options.max_connections = std::stoul(value);
+      } else if (arg == "--threads") {
+         options.threads = std::max<size_t>(1, std::stoul(value));
+      } else if (arg == "--duration") {
+         options.duration = std::stod(value);
+      } else if (arg == "--warmup") {
+         options.warmup = std::stod(value);
+      } else if (arg == "--rate") {
+         options.rate = std::stod(value);
+      } else if (arg == "--mix") {
+         options.mix = parseMix(value);
+      } else if (arg == "--table") {
+         options.table = value;
+      } else if (arg == "--rows") {
+         options.rows = std::max<size_t>(1, std::stoul(value));
+      } else if (arg == "--value-bytes") {
+         options.value_bytes = std::stoul(value);
+      } else if (arg == "--json") {
+         options.json_path = value;
+      } else if (arg == "--fake-latency-us") {
+         options.fake_latency_us = std::stoll(value);
+      } else if (arg == "--fake-jitter-us") {
+         options.fake_jitter_us = std::stoll(value);
+      } else {
+         throw std::invalid_argument("Unknown option " + arg);
+      }
+   }
+   if (options.duration <= 0 || options.warmup < 0 || options.rate < 0) {
+      throw std::invalid_argument("--duration must be positive, --warmup and --rate non-negative");
+   }
+   if (options.compare_reads) {
+      options.mix = {0, 0, 0, 50, 50};
+   }
+   return options;
+}
+
+// Fresh table with ids 1..rows, written with one COPY
+void setUp(DatabaseManager& db, const Options& options) {
+   db.tables().dropTable(options.table);
+   db.tables().createTable(options.table, "id SERIAL PRIMARY KEY, v TEXT");
+   std::string value(options.value_bytes, 'v');
+   size_t      written = 0;
+   db.data().bulkInsert(options.table, {"v"}, [&](DataModifier::Row& row) {
+      if (written++ == options.rows) {
+         return false;
+      }
+      row = {value};
+      return true;
+   });
+}
+
+// selectPrepared()'s point lookup by id, in a pqxx::work or a pqxx::nontransaction
+void pointRead(ConnectionPool& pool, const std::string& table, size_t id, bool in_transaction) {
+   auto handle = pool.getConnection();
+   try {
+      const std::string& statement =
+          handle.statements().prepare("SELECT * FROM " + handle->quote_name(table) + " WHERE id = $1");
+      if (in_transaction) {
+         pqxx::work txn(*handle);
+         txn.exec_prepared(statement, id);
+         txn.commit();
+      } else {
+         pqxx::nontransaction txn(*handle);
+         txn.exec_prepared(statement, id);
+      }
+   } catch (const std::exception& e) {
+      std::cerr << "Error in point read: " << e.what() << std::endl;
+      throw;
+   }
+}
+
+// The part of `later` recorded after `earlier` was taken. max_us can't be split, so it stays the run's max.
+LatencyHistogram::Snapshot since(const LatencyHistogram::Snapshot& later, const LatencyHistogram::Snapshot& earlier) {
+   LatencyHistogram::Snapshot window = later;
+   for (size_t b = 0; b < LatencyHistogram::kBuckets; ++b) {
+      window.buckets[b] -= earlier.buckets[b];
+   }
+   window.count -= earlier.count;
+   window.sum_us -= earlier.sum_us;
+   return window;
+}
+
+// `reads` is the pool the read_* kinds borrow from, and the one whose wait is reported when given
+Report run(DatabaseManager& db, ConnectionPool* reads, const Options& options) {
+   struct Worker {
+      std::vector<LatencySample>     samples;
+      std::array<uint64_t, kOpKinds> errors{};
+   };
+   std::vector<Worker> workers(options.threads);
+
+   auto seconds = [](double value) {
+      return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(value));
+   };
+   const size_t      mix_total    = std::accumulate(options.mix.begin(), options.mix.end(), size_t{0});
+   const auto        start        = Clock::now() + std::chrono::milliseconds(50); // every thread starts together
+   const auto        measure_from = start + seconds(options.warmup);
+   const auto        end          = measure_from + seconds(options.duration);
+   const double      thread_rate  = options.rate / static_cast<double>(options.threads);
+   const std::string value(options.value_bytes, 'u');
+
+   // Open loop knows how many operations each thread will record, so size the reservoirs to keep them all
+   auto capacity = [&](size_t kind) {
+      if (thread_rate <= 0) {
+         return kSamplesPerThreadAndKind;
+      }
+      double expected = thread_rate * options.duration * static_cast<double>(options.mix[kind]) / mix_total;
+      return std::clamp(static_cast<size_t>(expected * 1.25) + 64, kSamplesPerThreadAndKind,
+                        kMaxSamplesPerThreadAndKind);
+   };
+
+   std::vector<std::thread> threads;
+   for (size_t t = 0; t < options.threads; ++t) {
+      threads.emplace_back([&, t] {
+         Worker& worker = workers[t];
+         for (size_t k = 0; k < kOpKinds; ++k) {
+            worker.samples.emplace_back(capacity(k), static_cast<uint32_t>(t * kOpKinds + k + 1));
+         }
+         std::mt19937                          rng(static_cast<uint32_t>(t) + 1);
+         std::uniform_int_distribution<size_t> pick(0, mix_total - 1);
+         std::uniform_int_distribution<size_t> id(1, options.rows);
+         std::exponential_distribution<double> gap(thread_rate > 0 ? thread_rate : 1.0);
+
+         auto next = start;
+         std::this_thread::sleep_until(start);
+         for (;;) {
+            Clock::time_point scheduled;
+            if (thread_rate > 0) {
+               next += seconds(gap(rng));
+               if (next >= end) {
+                  break;
+               }
+               std::this_thread::sleep_until(next);
+               scheduled = next;
+            } else {
+               scheduled = Clock::now();
+               if (scheduled >= end) {
+                  break;
+               }
+            }
+
+            size_t roll = pick(rng);
+            size_t k    = 0;
+            while (roll >= options.mix[k]) {
+               roll -= options.mix[k++];
+            }
+            auto kind   = static_cast<OpKind>(k);
+            bool failed = false;
+            try {
+               switch (kind) {
+                  case OpKind::Select:
+                     db.query().selectPrepared(options.table, "id", std::to_string(id(rng)));
+                     break;
+                  case OpKind::Insert:
+                     db.data().insert(options.table, {"v"}, {value});
+                     break;
+                  case OpKind::Update:
+                     db.data().update(options.table, "v", value, "id", std::to_string(id(rng)));
+                     break;
+                  default:
+                     pointRead(*reads, options.table, id(rng), kind == OpKind::ReadWork);
+                     break;
+               }
+            } catch (const std::exception&) {
+               failed = true; // already logged by the operation
+            }
+            if (scheduled < measure_from) {
+               continue;
+            }
+            if (failed) {
+               ++worker.errors[k];
+            } else {
+               worker.samples[k].record(Clock::now() - scheduled);
+            }
+         }
+      });
+   }
+
+   std::this_thread::sleep_until(measure_from);
+   auto      pool_stats = [&] { return reads ? reads->stats() : db.getPoolStats(); };
+   PoolStats before     = pool_stats();
+   for (auto& thread : threads) {
+      thread.join();
+   }
+   PoolStats after = pool_stats();
+
+   Report report;
+   report.seconds = options.duration;
+   std::vector<const LatencySample*> all;
+   for (size_t k = 0; k < kOpKinds; ++k) {
+      std::vector<const LatencySample*> samples;
+      for (auto& worker : workers) {
+         report.ops[k].ok += worker.samples[k].recorded();
+         report.ops[k].errors += worker.errors[k];
+         report.ops[k].sampled = report.ops[k].sampled || worker.samples[k].sampled();
+         samples.push_back(&worker.samples[k]);
+      }
+      all.insert(all.end(), samples.begin(), samples.end());
+      report.ops[k].latency = Percentiles::of(samples);
+      report.total.ok += report.ops[k].ok;
+      report.total.errors += report.ops[k].errors;
+      report.total.sampled = report.total.sampled || report.ops[k].sampled;
+   }
+   report.total.latency = Percentiles::of(all);
+
+   report.pool.acquire_wait      = since(after.acquire_wait, before.acquire_wait);
+   report.pool.exhaustion_events = after.exhaustion_events - before.exhaustion_events;
+   report.pool.timeouts          = after.timeouts - before.timeouts;
+   report.pool.peak_waiters      = after.peak_waiters;
+   report.pool.total_connections = after.total_connections;
+   return report;
+}
+
+// Bucket upper bound in ms, or the observed max when the percentile lands in the open-ended last bucket
+double percentileMs(const LatencyHistogram::Snapshot& snapshot, double p) {
+   uint64_t us = snapshot.percentileUs(p);
+   return static_cast<double>(std::min(us, snapshot.max_us)) / 1000.0;
+}
+
+void printText(std::ostream& out, const Options& options, const Report& report) {
+   out << "\npgpool-load: " << options.threads << " threads, "
+       << (options.rate > 0 ? std::to_string(static_cast<long long>(options.rate)) + " ops/s target" : "closed loop")
+       << ", " << options.duration << " s measured after " << options.warmup << " s warm-up, pool "
+       << options.min_connections << ".." << options.max_connections << "\n";
+   out << "mix:";
+   for (size_t k = 0; k < kOpKinds; ++k) {
+      if (options.mix[k] > 0) {
+         out << " " << kOpNames[k] << "=" << options.mix[k];
+      }
+   }
+   out << "\n\n";
+
+   out << std::left << std::setw(12) << "op" << std::right << std::setw(10) << "count" << std::setw(8) << "errors"
+       << std::setw(11) << "ops/s" << std::setw(9) << "mean" << std::setw(9) << "p50" << std::setw(9) << "p95"
+       << std::setw(9) << "p99" << std::setw(9) << "p999" << std::setw(10) << "max" << "  (ms)\n";
+   auto row = [&](const char* name, const OpStats& stats) {
+      out << std::left << std::setw(12) << name << std::right << std::setw(10) << stats.ok << std::setw(8)
+          << stats.errors << std::fixed << std::setprecision(1) << std::setw(11) << stats.ok / report.seconds
+          << std::setprecision(3) << std::setw(9) << stats.latency.mean / 1000 << std::setw(9)
+          << stats.latency.p50 / 1000 << std::setw(9) << stats.latency.p95 / 1000 << std::setw(9)
+          << stats.latency.p99 / 1000 << std::setw(9) << stats.latency.p999 / 1000 << std::setw(10)
+          << stats.latency.max / 1000 << "\n";
+   };
+   for (size_t k = 0; k < kOpKinds; ++k) {
+      if (options.mix[k] > 0) {
+         row(kOpNames[k], report.ops[k]);
+      }
+   }
+   row("total", report.total);
+   if (report.total.sampled) {
+      out << "note: some threads recorded more than their reservoir holds, so percentiles are estimated from a "
+             "weighted sample; mean, max and counts are exact\n";
+   }
+
+   const auto& wait = report.pool.acquire_wait;
+   out << "\npool wait: " << wait.count << " borrows, mean " << std::setprecision(3) << wait.meanUs() / 1000
+       << " ms, p50 <= " << percentileMs(wait, 0.50) << " ms, p99 <= " << percentileMs(wait, 0.99)
+       << " ms, p999 <= " << percentileMs(wait, 0.999) << " ms, max " << wait.max_us / 1000.0 << " ms\n";
+   out << "pool: " << report.pool.total_connections << " connections open, " << report.pool.exhaustion_events
+       << " borrows queued, " << report.pool.timeouts << " timeouts; peak " << report.pool.peak_waiters
+       << " waiters over the whole run, setup and warm-up included\n";
+   out.unsetf(std::ios::floatfield);
+}
+
+void printJson(std::ostream& out, const Options& options, const Report& report) {
+   auto latency = [&](const Percentiles& p) {
+      std::ostringstream json;
+      json << "{\"mean\": " << p.mean / 1000 << ", \"p50\": " << p.p50 / 1000 << ", \"p95\": " << p.p95 / 1000
+           << ", \"p99\": " << p.p99 / 1000 << ", \"p999\": " << p.p999 / 1000 << ", \"max\": " << p.max / 1000
+           << "}";
+      return json.str();
+   };
+   auto op = [&](const OpStats& stats) {
+      std::ostringstream json;
+      json << "{\"count\": " << stats.ok << ", \"errors\": " << stats.errors
+           << ", \"ops_per_s\": " << stats.ok / report.seconds << ", \"latency_ms\": " << latency(stats.latency)
+           << ", \"latency_sampled\": " << (stats.sampled ? "true" : "false") << "}";
+      return json.str();
+   };
+
+   out << std::setprecision(6) << "{\n";
+   out << "  \"config\": {\"threads\": " << options.threads << ", \"duration_s\": " << options.duration
+       << ", \"warmup_s\": " << options.warmup << ", \"mode\": \"" << (options.rate > 0 ? "open" : "closed")
+       << "\", \"target_rate\": " << options.rate << ", \"min_connections\": " << options.min_connections
+       << ", \"max_connections\": " << options.max_connections << ", \"rows\": " << options.rows
+       << ", \"value_bytes\": " << options.value_bytes << ", \"fake_server\": " << (options.fake ? "true" : "false")
+       << ", \"mix\": {";
+   for (size_t k = 0; k < kOpKinds; ++k) {
+      out << (k ? ", " : "") << "\"" << kOpNames[k] << "\": " << options.mix[k];
+   }
+   out << "}},\n";
+   out << "  \"throughput\": " << report.total.ok / report.seconds << ",\n";
+   out << "  \"operations\": {";
+   for (size_t k = 0; k < kOpKinds; ++k) {
+      out << "\n    \"" << kOpNames[k] << "\": " << op(report.ops[k]) << ",";
+   }
+   out << "\n    \"total\": " << op(report.total) << "\n  },\n";
+
+   const auto& wait = report.pool.acquire_wait;
+   out << "  \"pool_wait\": {\"count\": " << wait.count << ", \"mean_ms\": " << wait.meanUs() / 1000
+       << ", \"p50_ms\": " << percentileMs(wait, 0.50) << ", \"p95_ms\": " << percentileMs(wait, 0.95)
+       << ", \"p99_ms\": " << percentileMs(wait, 0.99) << ", \"p999_ms\": " << percentileMs(wait, 0.999)
+       << ", \"max_ms\": " << wait.max_us / 1000.0 << ", \"exhaustion_events\": " << report.pool.exhaustion_events
+       << ", \"timeouts\": " << report.pool.timeouts << ", \"peak_waiters_whole_run\": " << report.pool.peak_waiters
+       << ", \"connections\": " << report.pool.total_connections << "}\n";
+   out << "}\n";
+}
+} // namespace
+
+int main(int argc, char* argv[]) {
+   Options options;
+   try {
+      options = parseArgs(argc, argv);
+   } catch (const std::exception& e) {
+      std::cerr << "pgpool-load: " << e.what() << std::endl;
+      return 2;
+   }
+
+#ifdef PGPOOL_HAVE_FAKEPG
+   std::unique_ptr<FakePgServer> fake; // declared before the manager so it outlives every connection
+   if (options.fake) {
+      FakePgOptions fake_options;
+      fake_options.rows    = 1; // the workload's selects are point lookups
+      fake_options.latency = std::chrono::microseconds(options.fake_latency_us);
+      fake_options.jitter  = std::chrono::microseconds(options.fake_jitter_us);
+      fake                 = std::make_unique<FakePgServer>(fake_options);
+      fake->start();
+      options.host = "127.0.0.1";
+      options.port = fake->port();
+   }
+#else
+   if (options.fake) {
+      std::cerr << "pgpool-load: built without the fake server (POSIX only)" << std::endl;
+      return 2;
+   }
+#endif
+
+   try {
+      PoolOptions pool_options;
+      pool_options.min_connections = options.min_connections;
+      pool_options.max_connections = options.max_connections;
+      DatabaseManager db(options.password, options.host, options.port, options.dbname, options.user, pool_options);
+      if (options.setup) {
+         setUp(db, options);
+      }
+
+      // --compare-reads borrows from a pool of its own so both read kinds share it and nothing else
+      std::unique_ptr<ConnectionPool> reads;
+      if (options.compare_reads) {
+         reads = std::make_unique<ConnectionPool>("host=" + options.host + " port=" + std::to_string(options.port) +
+                                                      " dbname=" + options.dbname + " user=" + options.user +
+                                                      " password=" + options.password,
+                                                  pool_options);
+      }
+
+      Report report = run(db, reads.get(), options);
+      printText(std::cout, options, report);
+      if (options.json_path == "-") {
+         std::cout << "\n";
+         printJson(std::cout, options, report);
+      } else if (!options.json_path.empty()) {
+         std::ofstream file(options.json_path);
+         printJson(file, options, report);
+         if (!file) {
+            throw std::runtime_error("Could not write " + options.json_path);
+         }
+         std::cout << "\nJSON report written to " << options.json_path << std::endl;
+      }
+      return 0;
+   } catch (const std::exception& e) {
+      std::cerr << "pgpool-load: " << e.what() << std::endl;
+      return 1;
+   }
+}
@@ -0,0 +1,43 @@
+// Copyright (c) 2025 Tanner Davison. All Rights Reserved.
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "ConnectionPool.hpp"
+
+// Stands in for pqxx::connection so the pool's own borrow/return cost can be timed without a server
+struct MockConnection {
+   // Simulated handshake, applied by every connect(). Zero makes connects free.
+   static inline std::atomic<int64_t> connect_delay_us{0};
+
+   std::atomic<bool> open{true};
+};
+
+// Nothing to cache on a mock session, but handles still hand out a StatementCache&
+struct MockStatements {};
+
+template <>
+struct ConnectionTraits<MockConnection> {
+   using StatementCache = MockStatements;
+
+   static std::unique_ptr<MockConnection> connect(const std::string&) {
+      auto delay = MockConnection::connect_delay_us.load(std::memory_order_relaxed);
+      if (delay > 0) {
+         std::this_thread::sleep_for(std::chrono::microseconds(delay));
+      }
+      return std::make_unique<MockConnection>();
+   }
+   static std::unique_ptr<StatementCache> attachStatements(MockConnection&, size_t) {
+      return std::make_unique<MockStatements>();
+   }
+   static bool isOpen(const MockConnection& conn) {
+      return conn.open.load(std::memory_order_relaxed);
+   }
+   static void ping(MockConnection&) {}
+};
+
+using MockConnectionPool = BasicConnectionPool<MockConnection>;
@@ -0,0 +1,107 @@
+// Copyright (c) 2025 Tanner Davison. All Rights Reserved.
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include "ConnectionPool.hpp"
+
+/**
+ * MutexPool
+ *   The pool as it was before the lock-free free list: one mutex around a vector of connections and a
+ *   FIFO queue of free indices, with a condition variable for borrowers waiting on a full pool. New
+ *   connections are opened under the mutex, exactly as the original did.
+ *
+ *   Kept only as pgpool_bench's baseline, so it takes the same Connection/Traits pair as
+ *   BasicConnectionPool. `waits` is the one addition: borrows that found no free connection and had to
+ *   block, which is what the new pool reports as exhaustion_events.
+ */
+template <typename Connection, typename Traits = ConnectionTraits<Connection>>
+class MutexPool {
+ public:
+   class ConnectionHandle {
+    public:
+      ConnectionHandle(Connection* c, MutexPool* p, size_t idx) : conn(c), pool(p), index(idx) {}
+      ConnectionHandle(ConnectionHandle&& other) noexcept : conn(other.conn), pool(other.pool), index(other.index) {
+         other.conn = nullptr;
+         other.pool = nullptr;
+      }
+      ~ConnectionHandle() {
+         if (pool && conn) {
+            pool->returnConnection(index);
+         }
+      }
+
+      Connection& operator*() {
+         return *conn;
+      }
+
+      ConnectionHandle(const ConnectionHandle&)            = delete;
+      ConnectionHandle& operator=(const ConnectionHandle&) = delete;
+      ConnectionHandle& operator=(ConnectionHandle&&)      = delete;
+
+    private:
+      Connection* conn;
+      MutexPool*  pool;
+      size_t      index;
+   };
+
+   MutexPool(const std::string& conn_str, size_t min_conns, size_t max_conns)
+       : connection_string(conn_str), max_connections(max_conns) {
+      for (size_t i = 0; i < min_conns; ++i) {
+         createConnection();
+      }
+   }
+
+   ConnectionHandle getConnection() {
+      std::unique_lock<std::mutex> lock(pool_mutex);
+      if (available_indices.empty() && connections.size() >= max_connections) {
+         ++wait_count;
+      }
+      pool_cv.wait(lock, [this] { return !available_indices.empty() || connections.size() < max_connections; });
+      if (available_indices.empty() && connections.size() < max_connections) {
+         createConnection();
+      }
+      size_t index = available_indices.front();
+      available_indices.pop();
+      connections[index].last_used = std::chrono::steady_clock::now();
+      return ConnectionHandle(connections[index].conn.get(), this, index);
+   }
+
+   uint64_t waits() const {
+      std::lock_guard<std::mutex> lock(pool_mutex);
+      return wait_count;
+   }
+
+ private:
+   struct PooledConnection {
+      std::unique_ptr<Connection>           conn;
+      std::chrono::steady_clock::time_point last_used;
+   };
+
+   void createConnection() {
+      connections.push_back({Traits::connect(connection_string), std::chrono::steady_clock::now()});
+      available_indices.push(connections.size() - 1);
+   }
+
+   void returnConnection(size_t index) {
+      std::lock_guard<std::mutex> lock(pool_mutex);
+      available_indices.push(index);
+      pool_cv.notify_one();
+   }
+
+   std::vector<PooledConnection> connections;
+   std::queue<size_t>            available_indices;
+   mutable std::mutex            pool_mutex;
+   std::condition_variable       pool_cv;
+   uint64_t                      wait_count = 0; // guarded by pool_mutex
+
+   const std::string connection_string;
+   const size_t      max_connections;
+};
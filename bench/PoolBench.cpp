@@ -0,0 +1,304 @@
+// pgpool_bench: borrow/return throughput and latency of the connection pool itself, against mock connections.
+//
+//   pgpool_bench [--impl lockfree,mutex] [--threads 1,2,4,8,16,32,64] [--pool 4,16]
+//                [--hold none,fixed:10,exp:50] [--seconds 1] [--shards 1] [--connect-us 0]
+//
+// Every combination of pool implementation, thread count, pool size and hold-time distribution runs for
+// --seconds. "lockfree" is BasicConnectionPool; "mutex" is the original mutex/queue/condvar pool kept in
+// MutexPool.hpp as the baseline. Each worker loops getConnection() -> hold -> return, timing the borrow
+// and the return separately. Holds are busy-waits (in microseconds) so short holds are exact; "exp" draws
+// them from an exponential distribution.
+
+#include "ConnectionPoolImpl.hpp"
+#include "LatencySample.hpp"
+#include "MockConnection.hpp"
+#include "MutexPool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+template class BasicConnectionPool<MockConnection>;
+using MockMutexPool = MutexPool<MockConnection>;
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t kSamplesPerThread = 1 << 18; // latencies kept per worker for each of borrow and return
+
+struct HoldTime {
+   enum class Kind { None, Fixed, Exponential };
+
+   Kind        kind    = Kind::None;
+   double      mean_us = 0;
+   std::string label   = "none";
+
+   static HoldTime parse(const std::string& spec) {
+      HoldTime hold;
+      hold.label = spec;
+      if (spec == "none") {
+         return hold;
+      }
+      auto colon = spec.find(':');
+      if (colon == std::string::npos) {
+         throw std::invalid_argument("Hold time must be none, fixed:<us> or exp:<us>, got '" + spec + "'");
+      }
+      std::string kind = spec.substr(0, colon);
+      hold.mean_us     = std::stod(spec.substr(colon + 1));
+      if (kind == "fixed") {
+         hold.kind = Kind::Fixed;
+      } else if (kind == "exp") {
+         hold.kind = Kind::Exponential;
+      } else {
+         throw std::invalid_argument("Unknown hold-time distribution '" + kind + "'");
+      }
+      return hold;
+   }
+};
+
+enum class PoolImpl { LockFree, Mutex };
+
+struct Options {
+   std::vector<PoolImpl> impls{PoolImpl::LockFree, PoolImpl::Mutex};
+   std::vector<size_t>   threads{1, 2, 4, 8, 16, 32, 64};
+   std::vector<size_t>   pool_sizes{4, 16};
+   std::vector<HoldTime> holds{HoldTime::parse("none"), HoldTime::parse("fixed:10"), HoldTime::parse("exp:50")};
+   double                seconds    = 1.0;
+   size_t                shards     = 1;
+   int64_t               connect_us = 0;
+};
+
+struct RunResult {
+   uint64_t    operations = 0;
+   double      seconds    = 0;
+   Percentiles borrow;
+   Percentiles give_back;
+   uint64_t    queued = 0; // borrows that found no free connection and had to wait
+};
+
+void spinFor(double us) {
+   auto until = Clock::now() + std::chrono::nanoseconds(static_cast<int64_t>(us * 1000.0));
+   while (Clock::now() < until) {
+   }
+}
+
+// The pool logs its warm-up to std::cout, which would interleave with the result table
+class MuteStdout {
+ public:
+   MuteStdout() : saved(std::cout.rdbuf(sink.rdbuf())) {}
+   ~MuteStdout() {
+      std::cout.rdbuf(saved);
+   }
+
+ private:
+   std::ostringstream sink;
+   std::streambuf*    saved;
+};
+
+std::unique_ptr<MockConnectionPool> makePool(const Options& options, size_t pool_size, MockConnectionPool*) {
+   PoolOptions pool_options;
+   pool_options.min_connections     = pool_size;
+   pool_options.max_connections     = pool_size;
+   pool_options.shards              = options.shards;
+   pool_options.validate_after_idle = std::chrono::milliseconds(0);
+   MuteStdout mute;
+   return std::make_unique<MockConnectionPool>("mock", pool_options);
+}
+
+std::unique_ptr<MockMutexPool> makePool(const Options&, size_t pool_size, MockMutexPool*) {
+   return std::make_unique<MockMutexPool>("mock", pool_size, pool_size);
+}
+
+uint64_t queuedBorrows(const MockConnectionPool& pool) {
+   return pool.stats().exhaustion_events;
+}
+
+uint64_t queuedBorrows(const MockMutexPool& pool) {
+   return pool.waits();
+}
+
+template <typename Pool>
+RunResult run(const Options& options, size_t threads, size_t pool_size, const HoldTime& hold) {
+   auto pool = makePool(options, pool_size, static_cast<Pool*>(nullptr));
+
+   std::atomic<bool>          go{false};
+   std::atomic<bool>          stop{false};
+   std::vector<LatencySample> borrow_samples;
+   std::vector<LatencySample> return_samples;
+   std::vector<uint64_t>      counts(threads, 0);
+   for (size_t t = 0; t < threads; ++t) {
+      borrow_samples.emplace_back(kSamplesPerThread, static_cast<uint32_t>(2 * t + 1));
+      return_samples.emplace_back(kSamplesPerThread, static_cast<uint32_t>(2 * t + 2));
+   }
+
+   std::vector<std::thread> workers;
+   for (size_t t = 0; t < threads; ++t) {
+      workers.emplace_back([&, t] {
+         std::mt19937                    rng(static_cast<uint32_t>(t));
+         std::exponential_distribution<> exponential(hold.mean_us > 0 ? 1.0 / hold.mean_us : 1.0);
+         uint64_t                        ops = 0;
+         while (!go.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+         }
+         while (!stop.load(std::memory_order_relaxed)) {
+            Clock::time_point returned;
+            auto              requested = Clock::now();
+            {
+               auto handle  = pool->getConnection();
+               auto granted = Clock::now();
+               borrow_samples[t].record(granted - requested);
+               if (hold.kind == HoldTime::Kind::Fixed) {
+                  spinFor(hold.mean_us);
+               } else if (hold.kind == HoldTime::Kind::Exponential) {
+                  spinFor(exponential(rng));
+               }
+               returned = Clock::now();
+            }
+            return_samples[t].record(Clock::now() - returned);
+            ++ops;
+         }
+         counts[t] = ops;
+      });
+   }
+
+   auto start = Clock::now();
+   go.store(true, std::memory_order_release);
+   std::this_thread::sleep_for(std::chrono::duration<double>(options.seconds));
+   stop.store(true);
+   for (auto& worker : workers) {
+      worker.join();
+   }
+
+   RunResult result;
+   result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+   std::vector<const LatencySample*> borrows, returns;
+   for (size_t t = 0; t < threads; ++t) {
+      result.operations += counts[t];
+      borrows.push_back(&borrow_samples[t]);
+      returns.push_back(&return_samples[t]);
+   }
+   result.borrow    = Percentiles::of(borrows);
+   result.give_back = Percentiles::of(returns);
+   result.queued    = queuedBorrows(*pool);
+   return result;
+}
+
+std::vector<std::string> splitList(const std::string& list) {
+   std::vector<std::string> items;
+   std::stringstream        stream(list);
+   for (std::string item; std::getline(stream, item, ',');) {
+      if (!item.empty()) {
+         items.push_back(item);
+      }
+   }
+   return items;
+}
+
+std::vector<size_t> parseSizes(const std::string& list) {
+   std::vector<size_t> sizes;
+   for (const auto& item : splitList(list)) {
+      size_t value = std::stoul(item);
+      if (value == 0) {
+         throw std::invalid_argument("Thread counts and pool sizes must be positive");
+      }
+      sizes.push_back(value);
+   }
+   return sizes;
+}
+
+Options parseArgs(int argc, char* argv[]) {
+   Options options;
+   for (int i = 1; i < argc; ++i) {
+      std::string arg = argv[i];
+      if (arg == "--help" || arg == "-h") {
+         std::cout << "usage: pgpool_bench [--impl lockfree,mutex] [--threads 1,2,4,8,16,32,64] [--pool 4,16]\n"
+                      "                    [--hold none,fixed:10,exp:50] [--seconds 1] [--shards 1] [--connect-us 0]\n";
+         std::exit(0);
+      }
+      if (i + 1 >= argc) {
+         throw std::invalid_argument("Missing value for " + arg);
+      }
+      std::string value = argv[++i];
+      if (arg == "--impl") {
+         options.impls.clear();
+         for (const auto& name : splitList(value)) {
+            if (name == "lockfree") {
+               options.impls.push_back(PoolImpl::LockFree);
+            } else if (name == "mutex") {
+               options.impls.push_back(PoolImpl::Mutex);
+            } else {
+               throw std::invalid_argument("Pool implementation must be lockfree or mutex, got '" + name + "'");
+            }
+         }
+      } else if (arg == "--threads") {
+         options.threads = parseSizes(value);
+      } else if (arg == "--pool") {
+         options.pool_sizes = parseSizes(value);
+      } else if (arg == "--hold") {
+         options.holds.clear();
+         for (const auto& spec : splitList(value)) {
+            options.holds.push_back(HoldTime::parse(spec));
+         }
+      } else if (arg == "--seconds") {
+         options.seconds = std::stod(value);
+      } else if (arg == "--shards") {
+         options.shards = std::stoul(value);
+      } else if (arg == "--connect-us") {
+         options.connect_us = std::stoll(value);
+      } else {
+         throw std::invalid_argument("Unknown option " + arg);
+      }
+   }
+   return options;
+}
+} // namespace
+
+int main(int argc, char* argv[]) {
+   Options options;
+   try {
+      options = parseArgs(argc, argv);
+   } catch (const std::exception& e) {
+      std::cerr << "pgpool_bench: " << e.what() << std::endl;
+      return 2;
+   }
+   MockConnection::connect_delay_us = options.connect_us;
+
+   std::cout << std::left << std::setw(10) << "impl" << std::setw(8) << "threads" << std::setw(6) << "pool"
+             << std::setw(12) << "hold" << std::right << std::setw(12) << "ops/s" << std::setw(10) << "b.p50"
+             << std::setw(10) << "b.p99" << std::setw(10) << "b.p999" << std::setw(10) << "b.max" << std::setw(10)
+             << "r.p50" << std::setw(10) << "r.p99" << std::setw(10) << "queued" << "\n";
+   std::cout << std::string(120, '-') << "\n";
+
+   // Implementations alternate innermost so each pair of rows compares like with like
+   for (size_t threads : options.threads) {
+      for (size_t pool_size : options.pool_sizes) {
+         for (const auto& hold : options.holds) {
+            for (PoolImpl impl : options.impls) {
+               RunResult result = impl == PoolImpl::LockFree
+                                      ? run<MockConnectionPool>(options, threads, pool_size, hold)
+                                      : run<MockMutexPool>(options, threads, pool_size, hold);
+               std::cout << std::left << std::setw(10) << (impl == PoolImpl::LockFree ? "lockfree" : "mutex")
+                         << std::setw(8) << threads << std::setw(6) << pool_size << std::setw(12) << hold.label
+                         << std::right << std::fixed << std::setprecision(0) << std::setw(12)
+                         << result.operations / result.seconds << std::setprecision(2) << std::setw(10)
+                         << result.borrow.p50 << std::setw(10) << result.borrow.p99 << std::setw(10)
+                         << result.borrow.p999 << std::setw(10) << result.borrow.max << std::setw(10)
+                         << result.give_back.p50 << std::setw(10) << result.give_back.p99 << std::setw(10)
+                         << result.queued << std::endl;
+            }
+         }
+      }
+   }
+   std::cout << "\nLatencies in microseconds; b = getConnection(), r = handle release. queued = borrows that "
+                "found no free connection and had to wait.\n";
+   return 0;
+}
@@ -0,0 +1,214 @@
+// pgpool_viewbench: time to first paint of the results pane, on the offscreen platform.
+//
+//   pgpool_viewbench [--rows 10000,100000,1000000] [--columns 4] [--value-bytes 32] [--repeat 3] [--no-baseline]
+//
+// Each result comes from an in-process FakePgServer through libpqxx, so the view gets a real pqxx::result
+// holding synthetic rows. Two paths are timed from "result in hand" to the end of a synchronous repaint:
+//
+//   model    ResultTableModel in a QTableView sized by estimateColumnWidths(), as displayResults() does
+//   widget   the path it replaced: every field copied to std::string, one QTableWidgetItem per cell, then
+//            resizeColumnsToContents()
+//
+// The fetch itself is timed separately and is the same for both. Each size runs --repeat times and the
+// median is printed. QT_QPA_PLATFORM overrides the offscreen default, e.g. to watch it on screen.
+
+#include "FakePgServer.hpp"
+#include "ResultTableModel.hpp"
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QHeaderView>
+#include <QStringList>
+#include <QTableView>
+#include <QTableWidget>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+struct Options {
+   std::vector<size_t> rows{10000, 100000, 1000000};
+   size_t              columns     = 4;
+   size_t              value_bytes = 32;
+   size_t              repeat      = 3;
+   bool                baseline    = true;
+};
+
+Options parseArgs(int argc, char* argv[]) {
+   Options options;
+   for (int i = 1; i < argc; ++i) {
+      std::string arg = argv[i];
+      if (arg == "--help" || arg == "-h") {
+         std::cout << "usage: pgpool_viewbench [--rows 10000,100000,1000000] [--columns 4] [--value-bytes 32]\n"
+                      "                        [--repeat 3] [--no-baseline]\n";
+         std::exit(0);
+      }
+      if (arg == "--no-baseline") {
+         options.baseline = false;
+         continue;
+      }
+      if (i + 1 >= argc) {
+         throw std::invalid_argument("Missing value for " + arg);
+      }
+      std::string value = argv[++i];
+      if (arg == "--rows") {
+         options.rows.clear();
+         std::stringstream stream(value);
+         for (std::string item; std::getline(stream, item, ',');) {
+            options.rows.push_back(std::stoul(item));
+         }
+      } else if (arg == "--columns") {
+         options.columns = std::max<size_t>(1, std::stoul(value));
+      } else if (arg == "--value-bytes") {
+         options.value_bytes = std::stoul(value);
+      } else if (arg == "--repeat") {
+         options.repeat = std::max<size_t>(1, std::stoul(value));
+      } else {
+         throw std::invalid_argument("Unknown option " + arg);
+      }
+   }
+   if (options.rows.empty()) {
+      throw std::invalid_argument("--rows needs at least one size");
+   }
+   return options;
+}
+
+double elapsedMs(const QElapsedTimer& timer) {
+   return static_cast<double>(timer.nsecsElapsed()) / 1e6;
+}
+
+double median(std::vector<double> values) {
+   std::sort(values.begin(), values.end());
+   return values[values.size() / 2];
+}
+
+void showAndSettle(QWidget& widget) {
+   widget.resize(1200, 800);
+   widget.show();
+   QApplication::processEvents(); // the empty view's own first paint stays out of the timing
+}
+
+// Same view settings as MainWindow's results pane
+double modelFirstPaint(const pqxx::result& result) {
+   ResultTableModel model;
+   QTableView       view;
+   view.setModel(&model);
+   view.horizontalHeader()->setStretchLastSection(true);
+   view.verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+   view.verticalHeader()->setDefaultSectionSize(view.fontMetrics().height() + 12);
+   view.setWordWrap(false);
+   showAndSettle(view);
+
+   QElapsedTimer timer;
+   timer.start();
+   model.setResult(result);
+   const std::vector<int> widths = model.estimateColumnWidths(view.fontMetrics());
+   for (size_t col = 0; col < widths.size(); ++col) {
+      view.setColumnWidth(static_cast<int>(col), widths[col]);
+   }
+   view.scrollToTop();
+   view.viewport()->repaint();
+   return elapsedMs(timer);
+}
+
+// The QTableWidget code displayResults() used before the model, including onExecuteQuery's string copy
+double widgetFirstPaint(const pqxx::result& result) {
+   QTableWidget table;
+   showAndSettle(table);
+
+   QElapsedTimer timer;
+   timer.start();
+   std::vector<std::string> columns;
+   for (pqxx::row::size_type col = 0; col < result.columns(); ++col) {
+      columns.push_back(result.column_name(col));
+   }
+   std::vector<std::vector<std::string>> rows;
+   for (auto const& row : result) {
+      std::vector<std::string> values;
+      for (auto const& field : row) {
+         values.push_back(field.is_null() ? "NULL" : field.c_str());
+      }
+      rows.push_back(std::move(values));
+   }
+
+   table.clear();
+   table.setColumnCount(static_cast<int>(columns.size()));
+   table.setRowCount(static_cast<int>(rows.size()));
+   QStringList headers;
+   for (const auto& col : columns) {
+      headers << QString::fromStdString(col);
+   }
+   table.setHorizontalHeaderLabels(headers);
+   for (size_t row = 0; row < rows.size(); ++row) {
+      for (size_t col = 0; col < rows[row].size(); ++col) {
+         table.setItem(static_cast<int>(row), static_cast<int>(col),
+                       new QTableWidgetItem(QString::fromStdString(rows[row][col])));
+      }
+   }
+   table.resizeColumnsToContents();
+   table.viewport()->repaint();
+   return elapsedMs(timer);
+}
+} // namespace
+
+int main(int argc, char* argv[]) {
+   if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+      qputenv("QT_QPA_PLATFORM", "offscreen");
+   }
+   QApplication app(argc, argv);
+
+   Options options;
+   try {
+      options = parseArgs(argc, argv);
+   } catch (const std::exception& e) {
+      std::cerr << "pgpool_viewbench: " << e.what() << std::endl;
+      return 2;
+   }
+
+   try {
+      FakePgOptions fake_options;
+      fake_options.rows        = *std::max_element(options.rows.begin(), options.rows.end());
+      fake_options.columns     = options.columns;
+      fake_options.value_bytes = options.value_bytes;
+      FakePgServer server(fake_options);
+      server.start();
+      pqxx::connection conn(server.connectionString());
+
+      std::cout << std::right << std::setw(10) << "rows" << std::setw(12) << "fetch ms" << std::setw(12)
+                << "model ms" << std::setw(12) << "widget ms" << "\n";
+      std::cout << std::string(46, '-') << "\n";
+      for (size_t rows : options.rows) {
+         std::vector<double> fetch, model, widget;
+         for (size_t i = 0; i < options.repeat; ++i) {
+            QElapsedTimer timer;
+            timer.start();
+            pqxx::result result = pqxx::nontransaction(conn).exec("SELECT * FROM bench LIMIT " + std::to_string(rows));
+            fetch.push_back(elapsedMs(timer));
+
+            model.push_back(modelFirstPaint(result));
+            if (options.baseline) {
+               widget.push_back(widgetFirstPaint(result));
+            }
+         }
+         std::cout << std::fixed << std::setprecision(1) << std::setw(10) << rows << std::setw(12) << median(fetch)
+                   << std::setw(12) << median(model);
+         if (options.baseline) {
+            std::cout << std::setw(12) << median(widget);
+         } else {
+            std::cout << std::setw(12) << "-";
+         }
+         std::cout << std::endl;
+      }
+      server.stop();
+      return 0;
+   } catch (const std::exception& e) {
+      std::cerr << "pgpool_viewbench: " << e.what() << std::endl;
+      return 1;
+   }
+}
@@ -0,0 +1,85 @@
+// Copyright (c) 2025 Tanner Davison. All Rights Reserved.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <pqxx/pqxx>
+
+struct ColumnarOptions {
+   // Columns are converted on separate threads once a page has at least this many cells
+   size_t parallel_threshold = 1 << 16;
+   size_t max_threads        = 0; // 0 = one per hardware thread
+
+   // Text columns stay dictionary-encoded while they have at most this many distinct values; 0 disables
+   size_t dictionary_max_distinct = 1024;
+};
+
+/**
+ * ColumnarResult
+ *   └─[owns]→ vector<Column>   (one contiguous typed vector per column, plus a NULL bitmap)
+ *
+ * Column types come from the result's type OIDs: integer types -> Int64, float4/float8/numeric -> Float64
+ * (numeric is rounded to double), bool -> Bool, date/timestamp/timestamptz -> Timestamp in microseconds
+ * since 1970-01-01 UTC, anything else -> Text. Text lives in one byte arena per column addressed by
+ * offsets, so a column costs two allocations instead of one std::string per cell.
+ *
+ * Pages can be appended one at a time (e.g. from a QueryCursor); the first page fixes the schema.
+ * A value that does not parse as its column type throws std::runtime_error.
+ */
+class ColumnarResult {
+ public:
+   enum class Type : uint8_t { Int64, Float64, Bool, Timestamp, Text };
+
+   struct Column {
+      std::string name;
+      Type        type = Type::Text;
+      pqxx::oid   oid  = 0;
+      size_t      rows = 0;
+
+      std::vector<uint64_t> nulls;   // bit per row, set = NULL (the typed slot holds 0)
+      std::vector<int64_t>  ints;    // Int64 and Timestamp
+      std::vector<double>   doubles; // Float64
+      std::vector<uint8_t>  bools;   // Bool
+
+      // Text: value i is arena[offsets[i], offsets[i + 1]). When `dictionary` is set, arena/offsets
+      // hold the distinct values instead and codes[row] picks one.
+      std::string           arena;
+      std::vector<uint32_t> offsets{0};
+      std::vector<uint32_t> codes;
+      bool                  dictionary = false;
+
+      bool             isNull(size_t row) const;
+      std::string_view text(size_t row) const; // Text columns only; empty for NULL
+      size_t           dictionarySize() const;
+      size_t           memoryBytes() const;
+   };
+
+   explicit ColumnarResult(const ColumnarOptions& options = ColumnarOptions());
+
+   static ColumnarResult from(const pqxx::result& result, const ColumnarOptions& options = ColumnarOptions());
+
+   void append(const pqxx::result& page);
+
+   size_t        rows() const;
+   size_t        columnCount() const;
+   const Column& column(size_t index) const;
+   const Column& column(std::string_view name) const; // throws std::out_of_range
+   size_t        memoryBytes() const;
+
+   static Type typeForOid(pqxx::oid oid);
+
+ private:
+   void appendColumn(size_t index, const pqxx::result& page);
+   void appendText(Column& column, std::unordered_map<std::string, uint32_t>& dictionary, std::string_view value);
+   void dropDictionary(Column& column, std::unordered_map<std::string, uint32_t>& dictionary);
+
+   ColumnarOptions                                        options;
+   std::vector<Column>                                    column_data;
+   std::vector<std::unordered_map<std::string, uint32_t>> dictionaries; // value -> code, while encoding
+   size_t                                                 row_count = 0;
+};
@@ -1,48 +1,170 @@
 // Copyright (c) 2025 Tanner Davison. All Rights Reserved.
 #pragma once
 
+#include <atomic>
 #include <chrono>
 #include <condition_variable>
+#include <cstdint>
+#include <deque>
 #include <memory>
 #include <mutex>
-#include <queue>
+#include <optional>
+#include <stdexcept>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <pqxx/pqxx>
 
+#include "LatencyHistogram.hpp"
+#include "PreparedStatementCache.hpp"
+
+struct PoolOptions {
+   size_t min_connections = 1;
+   size_t max_connections = 10;
+   size_t shards          = 1; // per-CPU sub-pools of idle connections; 0 = one per hardware thread
+
+   // Warm-up: the initial min_connections are opened concurrently by this many threads
+   size_t warmup_parallelism = 8;
+   bool   warmup_async       = false; // return once the first connection is ready, fill the rest in the background
+
+   // Maintenance thread: reaps, recycles and refills back to min_connections. Zero disables a limit.
+   std::chrono::milliseconds idle_timeout{0};  // close connections idle this long, down to min_connections
+   std::chrono::milliseconds max_lifetime{0};  // recycle connections older than this
+   size_t                    max_uses = 0;     // recycle after this many borrows
+   std::chrono::milliseconds maintenance_interval{1000};
+
+   // Borrow-time health check: is_open() always, plus a SELECT 1 ping once a connection sat idle this long
+   std::chrono::milliseconds validate_after_idle{30000};
+
+   size_t statement_cache_size = 64; // prepared statements kept per connection, least recently used evicted
+};
+
+// Point-in-time copy of the pool's counters, cheap enough to take on every metrics scrape
+struct PoolStats {
+   size_t total_connections  = 0;
+   size_t active_connections = 0;
+   size_t max_connections    = 0;
+   size_t waiters            = 0;
+   size_t peak_waiters       = 0;
+
+   uint64_t acquisitions      = 0; // handles granted (== acquire_wait.count)
+   uint64_t creations         = 0; // connections opened, including warm-up and refill
+   uint64_t creation_failures = 0;
+   uint64_t timeouts          = 0; // getConnection(timeout) deadlines missed
+   uint64_t exhaustion_events = 0; // borrows that had to queue for a connection
+   uint64_t broken_evictions  = 0; // connections found dead on borrow or on return
+
+   LatencyHistogram::Snapshot acquire_wait; // getConnection call -> handle granted
+   LatencyHistogram::Snapshot hold_time;    // handle granted -> ~ConnectionHandle
+};
+
+// How the pool opens, checks and closes one kind of connection. Specialize it to pool something other than
+// pqxx::connection, e.g. the mock connections pgpool_bench uses to time the pool without a server.
+template <typename Connection>
+struct ConnectionTraits;
+
+template <>
+struct ConnectionTraits<pqxx::connection> {
+   using StatementCache = PreparedStatementCache; // per-connection state that lives and dies with the session
+
+   static std::unique_ptr<pqxx::connection> connect(const std::string& conn_str) {
+      return std::make_unique<pqxx::connection>(conn_str);
+   }
+   static std::unique_ptr<StatementCache> attachStatements(pqxx::connection& conn, size_t capacity) {
+      return std::make_unique<PreparedStatementCache>(conn, capacity);
+   }
+   // pqxx closes the session itself when it sees the backend go away, so this is a free check
+   static bool isOpen(const pqxx::connection& conn) {
+      return conn.is_open();
+   }
+   static void ping(pqxx::connection& conn); // a SELECT 1 round trip, throws if the session is dead
+};
+
+// Thrown by getConnection(timeout) when no connection became available before the deadline
+class PoolTimeoutError : public std::runtime_error {
+ public:
+   using std::runtime_error::runtime_error;
+};
+
 /**
- * ConnectionPool
- *   ├─[owns]→ vector<PooledConnection>
- *   │            └─[contains]→ pqxx::connection
+ * BasicConnectionPool<Connection>                      (ConnectionPool = BasicConnectionPool<pqxx::connection>)
+ *   ├─[owns]→ vector<PooledConnection>   (fixed max_connections slots, never reallocated)
+ *   │            └─[contains]→ Connection  (opened, checked and pinged through ConnectionTraits<Connection>)
+ *   │
+ *   ├─[owns]→ Shard[]  (lock-free free lists of slot indices, fast path is atomics only)
+ *   │            └─ borrowers pop their own CPU's shard first and steal from neighbours when it is empty
  *   │
  *   └─[creates]→ ConnectionHandle
  *                  └─[borrows]→ PooledConnection
- *                  └─[references]→ ConnectionPool
+ *                  └─[references]→ BasicConnectionPool
+ *
+ * pool_mutex is only touched when the free list is empty (growth or exhaustion). Exhausted borrowers
+ * queue up FIFO, each parked on its own condition variable. Queued waiters don't close the fast path:
+ * a return pushes onto the free list and wakes at most one waiter to compete for it, so a thread that
+ * is already running can take the connection without a context switch. Once the oldest waiter has been
+ * parked for kHandoffAfter the pool switches to strict handoff, giving returns to the queue head until
+ * no waiter that old is left, which bounds how long barging can starve anyone.
+ * Growth reserves an empty slot under pool_mutex, then connects without holding it, so a slow
+ * handshake never blocks other borrowers and several growers can connect in parallel.
+ *
+ * The member definitions live in src/ConnectionPoolImpl.hpp. ConnectionPool.cpp instantiates the pqxx pool
+ * once; other connection types include the impl header themselves.
  */
-class ConnectionPool {
+template <typename Connection, typename Traits = ConnectionTraits<Connection>>
+class BasicConnectionPool {
  public:
    // Forward declare class
    class ConnectionHandle;
 
-   explicit ConnectionPool(const std::string& conn_str, size_t min_conns = 1, size_t max_conns = 10);
+   using StatementCache = typename Traits::StatementCache;
+
+   explicit BasicConnectionPool(const std::string& conn_str, size_t min_conns = 1, size_t max_conns = 10);
+   BasicConnectionPool(const std::string& conn_str, const PoolOptions& options);
+   ~BasicConnectionPool();
 
    ConnectionHandle getConnection();
+   // Throws PoolTimeoutError if no connection is handed over within `timeout`
+   template <typename Rep, typename Period>
+   ConnectionHandle getConnection(std::chrono::duration<Rep, Period> timeout) {
+      return acquire(std::chrono::steady_clock::now() +
+                     std::chrono::duration_cast<std::chrono::steady_clock::duration>(timeout));
+   }
+   // Never waits and never grows the pool: an idle connection or nothing
+   std::optional<ConnectionHandle> tryGetConnection();
+
    size_t           activeConnections() const;
    size_t           totalConnections() const;
 
+   PoolStats stats() const; // lock-free: reads atomics only
+
+   // Connect latency of each warm-up connection opened so far, in completion order
+   std::vector<std::chrono::milliseconds> warmupLatencies() const;
+
    /* <-----------------------ConnectionHandle NESTED CLASS ---------------------->*/
    class ConnectionHandle {
     public:
-      ConnectionHandle(pqxx::connection* c, ConnectionPool* p, size_t idx);
+      ConnectionHandle(Connection*                           c,
+                       BasicConnectionPool*                  p,
+                       size_t                                idx,
+                       std::chrono::steady_clock::time_point acquired = std::chrono::steady_clock::now());
       ConnectionHandle(ConnectionHandle&& other) noexcept;
       ~ConnectionHandle();
 
+      // Call after a pqxx::broken_connection (or anything else that leaves the session unusable) so
+      // the pool rebuilds this slot instead of lending it out again
+      void markBroken() {
+         broken = true;
+      }
+
+      // Prepared statements already on this connection's session
+      StatementCache& statements();
+
       // Overloaded Accessors
-      pqxx::connection& operator*() {
+      Connection& operator*() {
          return *conn;
       }
-      pqxx::connection* operator->() {
+      Connection* operator->() {
          return conn;
       }
 
@@ -52,33 +174,124 @@ class ConnectionPool {
       ConnectionHandle& operator=(ConnectionHandle&&)      = delete; // deleted move assaignment
 
     private:
-      pqxx::connection* conn;  // One specific connection
-      ConnectionPool*   pool;  // Reference back to pool
-      size_t            index; // Which connection we borrowed
+      Connection*          conn;  // One specific connection
+      BasicConnectionPool* pool;  // Reference back to pool
+      size_t               index; // Which connection we borrowed
+      bool                 broken = false;
+
+      std::chrono::steady_clock::time_point acquired_at; // start of the hold-time measurement
    };
 
    /* <-------------------ConnectionHandle END Of NESTED CLASS ----------------->*/
 
  private:
    struct PooledConnection {
-      std::unique_ptr<pqxx::connection>     conn;
-      std::chrono::steady_clock::time_point last_used;
-      bool                                  in_use;
+      std::unique_ptr<Connection>           conn;
+      std::unique_ptr<StatementCache>       statements; // declared after conn so it is destroyed first
+      std::chrono::steady_clock::time_point created_at;
+      std::chrono::steady_clock::time_point last_used; // when it was last returned
+      size_t                                use_count = 0;
+      bool                                  in_use    = false;
+   };
+
+   static constexpr uint32_t kNoIndex      = UINT32_MAX;
+   static constexpr int      kSpinLimit    = 64;                           // pop attempts before a borrower parks
+   static constexpr auto     kHandoffAfter = std::chrono::milliseconds(1); // park time that makes returns FIFO
+
+   // One free list per shard, padded so neighbouring shards never share a cache line
+   struct alignas(64) Shard {
+      std::atomic<uint64_t> free_head{kNoIndex}; // [ABA tag : 32 | slot index : 32]
+      std::atomic<int64_t>  idle{0};             // may dip below zero transiently when slots migrate
    };
 
    // Private Member variables
-   std::vector<PooledConnection> connections;
-   std::queue<size_t>            available_indices;
-   mutable std::mutex            pool_mutex; // mutable for const methods
-   std::condition_variable       pool_cv;
+   std::vector<PooledConnection>            connections; // sized to max_connections up front
+   std::unique_ptr<std::atomic<uint32_t>[]> next_free;   // intrusive links, shared by all shard free lists
+   // An exhausted borrower parked in wait_queue. Whoever frees capacity fills in the grant and
+   // signals that waiter's own condition variable; a plain return may only wake it to try again.
+   struct Waiter {
+      std::condition_variable               cv;
+      std::chrono::steady_clock::time_point parked_at;
+      size_t                                slot    = 0;
+      bool                                  granted = false; // `slot` is an idle connection handed over
+      bool                                  grow    = false; // `slot` is an empty slot reserved for us to connect into
+      bool                                  woken   = false; // woken to retry the free list, nothing handed over
+   };
+
+   const size_t                             shard_count;
+   const int                                spin_limit; // kSpinLimit, or 0 on one CPU where the holder can't run
+   std::unique_ptr<Shard[]>                 shards;
+   std::atomic<size_t>                      total_count{0};    // open connections
+   std::atomic<size_t>                      reserved_count{0}; // open + currently connecting
+   std::atomic<size_t>                      waiters{0};
+   std::atomic<bool>                        handoff{false}; // the queue head is owed the next return
+   std::atomic<bool>                        waking{false};  // a waiter is already woken, don't wake another
+
+   // Instrumentation. The histograms are striped per thread; the counters below only move on slow paths.
+   LatencyHistogram      acquire_wait;
+   LatencyHistogram      hold_time;
+   std::atomic<uint64_t> creations{0};
+   std::atomic<uint64_t> creation_failures{0};
+   std::atomic<uint64_t> timeouts{0};
+   std::atomic<uint64_t> exhaustion_events{0};
+   std::atomic<uint64_t> broken_evictions{0};
+   std::atomic<size_t>   peak_waiters{0};
+   std::vector<size_t>                      empty_slots; // slots with no connection, guarded by pool_mutex
+   std::deque<Waiter*>                      wait_queue;  // FIFO, guarded by pool_mutex
+   mutable std::mutex                       pool_mutex;  // growth and parking only
 
    const std::string connection_string;
    const size_t      max_connections;
    const size_t      min_connections;
 
+   std::vector<std::thread>               warmup_threads; // joined by the destructor
+   mutable std::mutex                     warmup_mutex;
+   std::vector<std::chrono::milliseconds> warmup_latencies;
+
+   const std::chrono::milliseconds idle_timeout;
+   const std::chrono::milliseconds max_lifetime;
+   const size_t                    max_uses;
+   const std::chrono::milliseconds maintenance_interval;
+   const std::chrono::milliseconds validate_after_idle;
+   const size_t                    statement_cache_size;
+   std::thread                     maintenance_thread;
+   std::mutex                      maint_mutex;
+   std::condition_variable         maint_cv;
+   std::vector<size_t>             retired; // borrowed-out slots due for closing, guarded by maint_mutex
+   bool                            stopping = false;
+
    // Private methods
-   void createConnection();
-   void returnConnection(size_t index); // Friend access for ConnectionHandle
+   static size_t resolveShardCount(const PoolOptions& options);
+   bool   reserveSlot(size_t& slot); // caller holds pool_mutex
+   void   releaseSlot(size_t slot);  // takes pool_mutex, hands the capacity to a waiter
+   void   dispatchWaiters();         // caller holds pool_mutex
+   void   wakeHead();                // caller holds pool_mutex and has set `waking`
+   void   updateHandoff();           // caller holds pool_mutex
+   bool   anyFree() const;
+   ConnectionHandle acquire(std::optional<std::chrono::steady_clock::time_point> deadline);
+   size_t createConnection(size_t slot); // connects into a reserved slot without holding pool_mutex
+   size_t localShard() const;
+   bool   popFree(size_t& index); // local shard first, then steal
+   bool   popShard(Shard& shard, size_t& index);
+   void   pushFree(size_t index, size_t shard);
+   void   publishIdle(size_t index, size_t shard); // pushFree + wake a parked waiter
+   void   warmUp(const PoolOptions& options);
+   bool   expired(const PooledConnection& pooled, std::chrono::steady_clock::time_point now) const;
+   void   retire(size_t index); // hands a slot to the maintenance thread to close
+   void   closeSlot(size_t index);
+   void   maintenanceLoop();
+   void   reapIdle();
+   void   refill();
+   ConnectionHandle lend(size_t                                index,
+                         std::chrono::steady_clock::time_point requested,
+                         std::chrono::steady_clock::time_point granted);
+   size_t take(std::optional<std::chrono::steady_clock::time_point> deadline, bool& fresh); // past the fast path
+   bool   healthy(size_t index, std::chrono::steady_clock::time_point now);
+   void   returnConnection(size_t index, bool broken, std::chrono::steady_clock::time_point acquired_at);
 
    friend class ConnectionHandle; // Allow handle to call returnConnection
 };
+
+extern template class BasicConnectionPool<pqxx::connection>; // instantiated once, in ConnectionPool.cpp
+
+using ConnectionPool = BasicConnectionPool<pqxx::connection>;
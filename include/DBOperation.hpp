@@ -1,11 +1,35 @@
 #pragma once
 #include "ConnectionPool.hpp"
+#include "OperationMetrics.hpp"
+#include <functional>
 #include <memory>
+#include <string>
+#include <vector>
 class DBOperation {
+ public:
+   enum class ChangeKind { Schema, Data };
+   // Called after a successful commit that changed `table`; an empty name means it is not known which
+   using ChangeListener = std::function<void(const std::string& table, ChangeKind kind)>;
+
  protected:
-   std::shared_ptr<ConnectionPool> pool;
+   std::shared_ptr<ConnectionPool>   pool;
+   std::shared_ptr<OperationMetrics> metrics; // optional, may be null
+   std::vector<ChangeListener>       listeners;
+
+   void notifyChanged(const std::string& table, ChangeKind kind) const {
+      for (const auto& listener : listeners) {
+         listener(table, kind);
+      }
+   }
 
  public:
-   explicit DBOperation(std::shared_ptr<ConnectionPool> connection_pool) : pool(connection_pool) {}
+   explicit DBOperation(std::shared_ptr<ConnectionPool>   connection_pool,
+                        std::shared_ptr<OperationMetrics> operation_metrics = nullptr)
+       : pool(connection_pool), metrics(operation_metrics) {}
    virtual ~DBOperation() = default;
+
+   // Not synchronized: register listeners before the operation is used from several threads
+   void addChangeListener(ChangeListener listener) {
+      listeners.push_back(std::move(listener));
+   }
 };
@@ -1,11 +1,83 @@
 #pragma once
 #include "DBOperation.hpp"
+#include <chrono>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class UnitOfWork;
+
+struct BulkInsertResult {
+   size_t                    rows = 0;
+   std::chrono::milliseconds elapsed{0};
+
+   double rowsPerSecond() const {
+      return elapsed.count() > 0 ? rows * 1000.0 / elapsed.count() : static_cast<double>(rows);
+   }
+};
 
 class DataModifier : public DBOperation {
  public:
+   using Row       = std::vector<std::optional<std::string>>; // std::nullopt is written as NULL
+   using RowSource = std::function<bool(Row& row)>;           // fills `row`, returns false once exhausted
+
    using DBOperation::DBOperation;
    int    insert(const std::string& table, const std::vector<std::string>& columns,
                  const std::vector<std::string>& values);
    size_t update(const std::string& table, const std::string& set_column, const std::string& set_value,
                  const std::string& where_column, const std::string& where_value);
+
+   // Streams rows through COPY ... FROM STDIN in a single transaction. Rows are pulled from
+   // `next_row` one at a time, so the source is never buffered in memory.
+   BulkInsertResult bulkInsert(const std::string& table, const std::vector<std::string>& columns,
+                               const RowSource& next_row);
+
+   // Multi-row INSERT ... VALUES (...),(...), chunked to stay under PostgreSQL's 65535 bind parameter
+   // limit, all in one transaction. Ids come back in input order: they are reserved from the table's
+   // serial or identity `id` sequence first and inserted explicitly, so `columns` must not name `id`.
+   std::vector<int> insertMany(const std::string& table, const std::vector<std::string>& columns,
+                               const std::vector<Row>& rows);
+
+   // Same statements, run inside a caller's (sub)transaction; nothing is committed here
+   int    insert(pqxx::transaction_base& txn, const std::string& table, const std::vector<std::string>& columns,
+                 const Row& values);
+   size_t update(pqxx::transaction_base& txn, const std::string& table, const std::string& set_column,
+                 const std::string& set_value, const std::string& where_column, const std::string& where_value);
+
+   // One connection and one transaction for everything `body` does through the UnitOfWork, committed
+   // once when it returns. If it throws, the whole unit is rolled back and the exception propagates.
+   void transaction(const std::function<void(UnitOfWork& work)>& body);
+
+   template <typename RowIterator>
+   BulkInsertResult bulkInsert(const std::string& table, const std::vector<std::string>& columns, RowIterator first,
+                               RowIterator last) {
+      return bulkInsert(table, columns, [&](Row& row) {
+         if (first == last) {
+            return false;
+         }
+         row.assign(std::begin(*first), std::end(*first));
+         ++first;
+         return true;
+      });
+   }
+
+ private:
+   static constexpr size_t kMaxBindParams       = 65535;
+   static constexpr size_t kMaxRowsPerStatement = 1000; // keeps statement text and plans reasonable
+
+   // INSERT ... VALUES text for `rows` rows of this table/column shape. Without `explicit_ids` it ends in
+   // RETURNING id; with it, each row leads with an id parameter and no RETURNING clause is added.
+   static std::string buildInsertSql(pqxx::connection& conn, const std::string& table,
+                                     const std::vector<std::string>& columns, size_t rows, bool explicit_ids = false);
+   // Same text, built once and reused afterwards. Only the single-row and full-chunk sizes go through
+   // here, so the cache holds at most two entries per table/column shape.
+   const std::string& insertSql(pqxx::connection& conn, const std::string& table,
+                                const std::vector<std::string>& columns, size_t rows, bool explicit_ids = false);
+
+   std::mutex                                   sql_mutex;
+   std::unordered_map<std::string, std::string> sql_texts; // guarded by sql_mutex, never erased
 };
@@ -2,13 +2,24 @@
 // testing
 #include "DataModifier.hpp"
 #include "QueryExecutor.hpp"
+#include "SchemaCache.hpp"
 #include "TableCreator.hpp"
+#include "TaskExecutor.hpp"
+#include "UnitOfWork.hpp"
+#include <future>
 class DatabaseManager {
  private:
-   std::shared_ptr<ConnectionPool> pool;
-   std::unique_ptr<TableCreator>   table_ops;
-   std::unique_ptr<QueryExecutor>  query_ops;
-   std::unique_ptr<DataModifier>   data_ops;
+   std::shared_ptr<ConnectionPool>   pool;
+   std::shared_ptr<OperationMetrics> metrics;
+   std::unique_ptr<TableCreator>     table_ops;
+   std::unique_ptr<QueryExecutor>    query_ops;
+   std::unique_ptr<DataModifier>     data_ops;
+   std::unique_ptr<SchemaCache>      schema_cache;
+   std::shared_ptr<QueryResultCache> result_cache; // null until enableResultCache(); atomic_load/atomic_store
+   std::string                       connection_string;
+   std::unique_ptr<TaskExecutor>     executor; // declared last: drains queued work before the ops go away
+
+   static constexpr size_t kAsyncQueuePerWorker = 4; // submissions beyond this block the caller
 
  public:
    DatabaseManager(const std::string& password,
@@ -18,13 +29,39 @@ class DatabaseManager {
                    const std::string& user            = "tanner",
                    size_t             min_connections = 2,
                    size_t             max_connections = 10);
+   DatabaseManager(const std::string& password,
+                   const std::string& host,
+                   int                port,
+                   const std::string& dbname,
+                   const std::string& user,
+                   const PoolOptions& pool_options);
    void   testConnection();
    size_t getActiveConnections() const;
 
    size_t         getTotalConnections() const;
+   PoolStats      getPoolStats() const;
+
+   const OperationMetrics& operationMetrics() const;
    TableCreator&  tables();
    QueryExecutor& query();
    DataModifier&  data();
+   SchemaCache&   schema(); // invalidated automatically by tables().createTable/dropTable
+
+   // Run on an internal worker pool sized to max_connections. Arguments are copied into the task;
+   // the futures rethrow whatever the blocking call would have thrown. Blocks while the queue is full.
+   std::future<pqxx::result> selectAsync(std::string query);
+   std::future<int>          insertAsync(std::string table, std::vector<std::string> columns,
+                                         std::vector<std::string> values);
+   std::future<size_t>       updateAsync(std::string table, std::string set_column, std::string set_value,
+                                         std::string where_column, std::string where_value);
+
+   // Turns on query().selectCached() caching. Writes through data() and tables() invalidate affected
+   // entries; options.listen_channel adds invalidation by NOTIFY from other processes.
+   void                                    enableResultCache(const ResultCacheOptions& options = ResultCacheOptions());
+   std::shared_ptr<const QueryResultCache> resultCache() const; // nullptr while disabled
+
+   // Many inserts/updates on one connection with a single commit; see DataModifier::transaction
+   void transaction(const std::function<void(UnitOfWork& work)>& body);
 
    void printPoolStats();
 };
@@ -6,6 +6,7 @@
 #include <QLineEdit>
 #include <QPushButton>
 #include <QTableWidget>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -30,6 +31,9 @@ class InsertDialog : public QDialog {
  private:
    void setupUI();
    void fetchTableColumns(const std::string& tableName);
+   // std::nullopt for blank or NULL cells, so they bind as SQL NULL; false when the row is blank
+   bool collectRow(int row, std::vector<std::optional<std::string>>& values) const;
+   void insertRowsIndividually(const std::string& table, const std::vector<int>& dataRows, const QString& copyError);
 
    DatabaseManager* m_dbManager;
    QComboBox*       m_tableCombo;
@@ -0,0 +1,48 @@
+// Copyright (c) 2025 Tanner Davison. All Rights Reserved.
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * LatencyHistogram
+ *   Power-of-two microsecond buckets: bucket 0 counts samples under 1us, bucket i counts samples in
+ *   [2^(i-1), 2^i) us, and the last bucket catches everything slower (~16s and up).
+ *
+ *   record() is lock-free: each thread writes to one of a few cache-line sized stripes with relaxed
+ *   atomics, and snapshot() sums the stripes. The adds are single instructions; only raising the max
+ *   is a compare-and-swap loop, retried while another thread on the stripe raises it too. A snapshot
+ *   taken while others record is not a single instant, but every counter in it is individually exact.
+ */
+class LatencyHistogram {
+ public:
+   static constexpr size_t kBuckets = 26;
+
+   struct Snapshot {
+      std::array<uint64_t, kBuckets> buckets{};
+      uint64_t                       count  = 0;
+      uint64_t                       sum_us = 0;
+      uint64_t                       max_us = 0;
+
+      static uint64_t upperBoundUs(size_t bucket); // exclusive upper bound, UINT64_MAX for the last bucket
+      double          meanUs() const;
+      uint64_t        percentileUs(double p) const; // upper bound of the bucket holding the p-th percentile
+   };
+
+   void     record(std::chrono::steady_clock::duration elapsed);
+   Snapshot snapshot() const;
+
+ private:
+   static constexpr size_t kStripes = 8;
+
+   struct alignas(64) Stripe {
+      std::array<std::atomic<uint64_t>, kBuckets> buckets{}; // their sum is the stripe's count
+      std::atomic<uint64_t>                       sum_us{0};
+      std::atomic<uint64_t>                       max_us{0};
+   };
+
+   std::array<Stripe, kStripes> stripes;
+};
@@ -2,11 +2,12 @@
 #define MAINWINDOW_HPP
 
 #include "DatabaseManager.hpp"
+#include <QCheckBox>
 #include <QComboBox>
 #include <QLineEdit>
 #include <QMainWindow>
 #include <QPushButton>
-#include <QTableWidget>
+#include <QTableView>
 #include <QTextEdit>
 #include <memory>
 
@@ -17,6 +18,9 @@ class QLabel;
 class QSpinBox;
 QT_END_NAMESPACE
 
+class MetricsServer;
+class ResultTableModel;
+
 class MainWindow : public QMainWindow {
    Q_OBJECT
 
@@ -36,7 +40,9 @@ class MainWindow : public QMainWindow {
  private:
    void setupUI();
    void createMenuBar();
-   void displayResults(const std::vector<std::vector<std::string>>& results, const std::vector<std::string>& columns);
+   void displayResults(pqxx::result result); // returns once the first page of rows has been painted
+   void browseResults(const std::string& query); // pages rows in through a cursor as the view scrolls
+   void fitColumns();
 
    // UI Elements
    QLineEdit* m_hostEdit;
@@ -53,15 +59,18 @@ class MainWindow : public QMainWindow {
    QPushButton* m_insertBtn;
    QPushButton* m_toggleQueryBtn;
 
-   QComboBox*    m_tableCombo;
-   QTextEdit*    m_queryEdit;
-   QTableWidget* m_resultsTable;
-   QTextEdit*    m_logOutput;
-   QLabel*       m_statusLabel;
-   QLabel*       m_current_date;
+   QComboBox*        m_tableCombo;
+   QCheckBox*        m_browseCheck; // SELECTs page in lazily instead of loading the whole result
+   QTextEdit*        m_queryEdit;
+   QTableView*       m_resultsView;
+   ResultTableModel* m_resultsModel;
+   QTextEdit*        m_logOutput;
+   QLabel*           m_statusLabel;
+   QLabel*           m_current_date;
 
    // Database components
    std::unique_ptr<DatabaseManager> m_dbManager;
+   MetricsServer*                   m_metricsServer = nullptr; // only when PGPOOL_METRICS_PORT is set
 
    bool m_isConnected;
    bool m_queryGroupExpanded = true;
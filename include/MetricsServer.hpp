@@ -0,0 +1,38 @@
+#ifndef METRICSSERVER_HPP
+#define METRICSSERVER_HPP
+
+#include <QByteArray>
+#include <QObject>
+
+QT_BEGIN_NAMESPACE
+class QTcpServer;
+class QTcpSocket;
+QT_END_NAMESPACE
+
+class DatabaseManager;
+
+// Minimal HTTP listener on localhost that serves GET /metrics in Prometheus text format.
+// Runs on the GUI event loop; a scrape only copies lock-free counter snapshots.
+class MetricsServer : public QObject {
+   Q_OBJECT
+
+ public:
+   explicit MetricsServer(QObject* parent = nullptr);
+
+   bool    listen(quint16 port);
+   quint16 port() const;
+   void    setDatabase(DatabaseManager* dbManager); // nullptr while disconnected
+
+   static QByteArray render(const DatabaseManager* dbManager);
+
+ private slots:
+   void onNewConnection();
+
+ private:
+   void respond(QTcpSocket* socket, const QByteArray& requestLine);
+
+   QTcpServer*      m_server;
+   DatabaseManager* m_dbManager = nullptr;
+};
+
+#endif // METRICSSERVER_HPP
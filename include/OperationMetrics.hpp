@@ -0,0 +1,80 @@
+// Copyright (c) 2025 Tanner Davison. All Rights Reserved.
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+
+#include "LatencyHistogram.hpp"
+
+/**
+ * OperationMetrics
+ *   Per-operation latency histograms and error counters for the DBOperation classes.
+ *   Shared by every operation object of one DatabaseManager; recording never locks.
+ */
+class OperationMetrics {
+ public:
+   enum class Op : size_t {
+      Select,
+      SelectPrepared,
+      SelectMany,
+      SelectCached,
+      ReadSnapshot,
+      Stream,
+      SelectColumnar,
+      Insert,
+      Update,
+      CreateTable,
+      DropTable,
+      BulkInsert,
+      InsertMany,
+      Transaction,
+      Count
+   };
+
+   static constexpr size_t kOpCount = static_cast<size_t>(Op::Count);
+   static const char*      name(Op op); // label value used in exported metrics
+
+   struct Snapshot {
+      LatencyHistogram::Snapshot latency;
+      uint64_t                   errors = 0;
+   };
+
+   void     record(Op op, std::chrono::steady_clock::duration elapsed, bool failed);
+   Snapshot snapshot(Op op) const;
+
+   // Times the enclosing scope; leaving it by exception counts as an error. A null registry is a no-op.
+   class Timer {
+    public:
+      Timer(OperationMetrics* registry, Op op)
+          : metrics(registry)
+          , operation(op)
+          , started(std::chrono::steady_clock::now())
+          , exceptions_at_start(std::uncaught_exceptions()) {}
+      ~Timer() {
+         if (metrics) {
+            metrics->record(
+                operation, std::chrono::steady_clock::now() - started, std::uncaught_exceptions() > exceptions_at_start);
+         }
+      }
+      Timer(const Timer&)            = delete;
+      Timer& operator=(const Timer&) = delete;
+
+    private:
+      OperationMetrics*                     metrics;
+      Op                                    operation;
+      std::chrono::steady_clock::time_point started;
+      int                                   exceptions_at_start;
+   };
+
+ private:
+   struct Entry {
+      LatencyHistogram      latency;
+      std::atomic<uint64_t> errors{0};
+   };
+
+   std::array<Entry, kOpCount> entries;
+};
@@ -0,0 +1,48 @@
+// Copyright (c) 2025 Tanner Davison. All Rights Reserved.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include <pqxx/pqxx>
+
+/**
+ * PreparedStatementCache
+ *   Server-side prepared statements of one pooled connection, keyed by whitespace-normalized SQL.
+ *   Statements are prepared lazily on first use and the least recently used one is DEALLOCATEd once
+ *   `capacity` is exceeded. The cache lives and dies with its connection, so recycling a connection
+ *   drops its entries with it.
+ *
+ *   Not thread-safe: only the thread holding the connection's handle may touch it, and prepare()
+ *   must be called outside an open transaction.
+ */
+class PreparedStatementCache {
+ public:
+   PreparedStatementCache(pqxx::connection& connection, size_t capacity);
+
+   // Returns the statement name to pass to exec_prepared(), preparing `sql` on first use
+   const std::string& prepare(const std::string& sql);
+
+   size_t   size() const;
+   uint64_t hits() const;
+   uint64_t misses() const;
+
+   // Collapses whitespace outside string constants (including E'...' and $$...$$), quoted identifiers
+   // and comments, so equivalent spellings of one statement share a key
+   static std::string normalize(const std::string& sql);
+
+ private:
+   using Entry = std::pair<std::string, std::string>; // normalized sql, statement name
+
+   pqxx::connection&                                           conn;
+   const size_t                                                capacity;
+   std::list<Entry>                                            lru; // front = most recently used
+   std::unordered_map<std::string, std::list<Entry>::iterator> index;
+   uint64_t                                                    next_id    = 0;
+   uint64_t                                                    hit_count  = 0;
+   uint64_t                                                    miss_count = 0;
+};
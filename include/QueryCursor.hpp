@@ -0,0 +1,46 @@
+// Copyright (c) 2025 Tanner Davison. All Rights Reserved.
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include <pqxx/pqxx>
+
+#include "ConnectionPool.hpp"
+
+/**
+ * QueryCursor
+ *   ├─[borrows]→ ConnectionHandle   (held for the cursor's lifetime only)
+ *   └─[owns]→ pqxx::work
+ *                └─ DECLARE ... NO SCROLL CURSOR, read page by page with FETCH FORWARD
+ *
+ * Only one page of rows is in client memory at a time, however large the result. Destroying the
+ * cursor (or close()) ends the transaction and gives the connection back to the pool.
+ */
+class QueryCursor {
+ public:
+   QueryCursor(ConnectionPool::ConnectionHandle handle, const std::string& query, size_t fetch_size);
+   ~QueryCursor();
+
+   pqxx::result fetch();            // next page of up to fetchSize() rows; empty once exhausted
+   pqxx::result fetch(size_t rows); // next page of up to `rows` rows
+   void         close();            // releases the connection early
+
+   bool   exhausted() const;
+   size_t rowsFetched() const;
+   size_t fetchSize() const;
+
+   // Deleted operations
+   QueryCursor(const QueryCursor&)            = delete;
+   QueryCursor& operator=(const QueryCursor&) = delete;
+
+ private:
+   std::optional<ConnectionPool::ConnectionHandle> handle; // empty after close()
+   std::unique_ptr<pqxx::work>                     txn;    // declared after handle so it ends first
+   std::string                                     name;
+   size_t                                          page_size;
+   size_t                                          fetched = 0;
+   bool                                            done    = false;
+};
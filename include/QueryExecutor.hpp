@@ -1,13 +1,87 @@
 #pragma once
+#include "ColumnarResult.hpp"
 #include "DBOperation.hpp"
+#include "QueryCursor.hpp"
+#include "QueryResultCache.hpp"
 #include <cerrno>
+#include <functional>
 #include <iostream>
+#include <memory>
 #include <pqxx/pqxx>
+#include <string>
+#include <vector>
+
+// Outcome of one query in a selectMany() batch: either a result or the error it raised
+struct QueryOutcome {
+   pqxx::result result;
+   std::string  error; // empty on success
+
+   bool ok() const {
+      return error.empty();
+   }
+};
+
+struct BatchResult {
+   std::vector<QueryOutcome> outcomes;               // same order as the queries passed in
+   size_t                    round_trips       = 0; // pipeline flushes actually made
+   size_t                    round_trips_saved = 0; // versus one select() per query
+
+   size_t failures() const;
+};
 
 class QueryExecutor : public DBOperation {
  public:
    using DBOperation::DBOperation;
+
+   // Single-statement reads run in autocommit (pqxx::nontransaction): one round trip per query
+   // instead of BEGIN, query, COMMIT. Each statement still sees its own consistent snapshot.
    pqxx::result select(const std::string& query);
 
    pqxx::result selectPrepared(const std::string& table, const std::string& condition_column, const std::string& value);
+
+   // Opt-in result cache: served from memory while fresh, otherwise run like select() and stored.
+   // `params` bind to $1, $2, ... The shared result is immutable and safe to read from any thread.
+   //
+   // A hit doesn't run the query at all, so only pass plain reads of tables. Not safe to cache:
+   //  - side effects (nextval(), INSERT ... RETURNING, functions that write): skipped on every hit;
+   //  - volatile values (now(), random()): frozen for the TTL;
+   //  - anything whose inputs change without a write through DataModifier/TableCreator, such as writes
+   //    from other processes (unless ResultCacheOptions::listen_channel is NOTIFYed) or the session's
+   //    settings: stale for the TTL.
+   // Function calls and views still get cached, but any write then drops the entry.
+   QueryResultCache::ResultPtr selectCached(const std::string&                       query,
+                                            const std::vector<std::string>&          params = {},
+                                            std::optional<std::chrono::milliseconds> ttl    = std::nullopt);
+   void setResultCache(std::shared_ptr<QueryResultCache> cache); // nullptr disables caching
+
+   // For several reads that must agree with each other: `body` runs inside one REPEATABLE READ,
+   // READ ONLY transaction on one connection, committed when it returns
+   using SnapshotTransaction = pqxx::transaction<pqxx::isolation_level::repeatable_read, pqxx::write_policy::read_only>;
+   void readSnapshot(const std::function<void(SnapshotTransaction& txn)>& body);
+
+   // Sends every query on one connection through pqxx::pipeline, so N independent reads cost about one
+   // round trip instead of N. A failing query's error is recorded and the queries after it are resent
+   // on a fresh pipeline. For independent reads only: each batch runs as one implicit transaction, so
+   // a failure also rolls back any writes batched before it, even though their results were reported.
+   BatchResult selectMany(const std::vector<std::string>& queries);
+
+   // Large results: rows arrive fetch_size at a time instead of as one fully materialized pqxx::result
+   static constexpr size_t kDefaultFetchSize = 1000;
+
+   // Keeps a pooled connection for as long as the cursor lives
+   std::unique_ptr<QueryCursor> openCursor(const std::string& query, size_t fetch_size = kDefaultFetchSize);
+
+   // Calls on_row for every row until it returns false; returns how many rows were delivered
+   size_t stream(const std::string&                           query,
+                 const std::function<bool(const pqxx::row&)>& on_row,
+                 size_t                                       fetch_size = kDefaultFetchSize);
+
+   // Typed column vectors for exports/analytics, built page by page from a cursor so the full
+   // row-oriented pqxx::result never exists at once
+   ColumnarResult selectColumnar(const std::string&     query,
+                                 const ColumnarOptions& options    = ColumnarOptions(),
+                                 size_t                 fetch_size = kDefaultFetchSize * 10);
+
+ private:
+   std::shared_ptr<QueryResultCache> result_cache; // accessed with std::atomic_load/atomic_store
 };
@@ -0,0 +1,131 @@
+// Copyright (c) 2025 Tanner Davison. All Rights Reserved.
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <pqxx/pqxx>
+
+struct ResultCacheOptions {
+   size_t                    max_bytes = 64 * 1024 * 1024; // estimated result size, LRU-evicted beyond this
+   std::chrono::milliseconds ttl{5000};                     // default lifetime of an entry
+
+   // When set, a dedicated connection LISTENs here. A NOTIFY payload names a changed table;
+   // an empty payload or "*" drops everything. Covers writes made by other processes.
+   std::string listen_channel;
+};
+
+/**
+ * QueryResultCache
+ *   ├─[owns]→ list<Entry>            (LRU order, front = most recently used)
+ *   │            └─[shares]→ const pqxx::result   (handed out as shared_ptr, never copied)
+ *   ├─[indexes]→ table -> entry keys (write-driven invalidation)
+ *   └─[owns]→ listener thread        (optional LISTEN connection, outside the pool)
+ *
+ * Entries depend on the relations named in their SQL. Writes reported through invalidateTable() drop
+ * every entry naming that table. An entry whose dependencies could not be worked out is dropped by any
+ * write: a function call anywhere in the SQL (beyond a few read-only builtins), or a relation that the
+ * PlainTableCheck doesn't vouch for, such as a view. Thread-safe.
+ */
+class QueryResultCache {
+ public:
+   using ResultPtr = std::shared_ptr<const pqxx::result>;
+   // True when writes to `table` are reported under that name, i.e. it is an ordinary table. Without
+   // one, every relation a query names is taken to be a table.
+   using PlainTableCheck = std::function<bool(const std::string& table)>;
+
+   struct Stats {
+      uint64_t hits          = 0;
+      uint64_t misses        = 0;
+      uint64_t evictions     = 0; // pushed out by the byte limit
+      uint64_t invalidations = 0; // dropped by a write or NOTIFY
+      size_t   entries       = 0;
+      size_t   bytes         = 0;
+
+      double hitRate() const {
+         return hits + misses > 0 ? static_cast<double>(hits) / static_cast<double>(hits + misses) : 0.0;
+      }
+   };
+
+   explicit QueryResultCache(const ResultCacheOptions& options        = ResultCacheOptions(),
+                             PlainTableCheck           is_plain_table = nullptr);
+   ~QueryResultCache();
+
+   // Normalized SQL plus parameters, so formatting differences share an entry
+   static std::string key(const std::string& sql, const std::vector<std::string>& params = {});
+   // Lower-cased, unqualified relation names after FROM/JOIN. False if some dependency is unknown,
+   // including any function call other than a few read-only builtins.
+   static bool referencedTables(const std::string& sql, std::vector<std::string>& tables);
+   static std::string normalizeTable(const std::string& table);
+
+   ResultPtr get(const std::string& key); // nullptr on miss or expiry
+
+   // Writes seen since `epoch` (from writeEpoch(), read before running the query) make the result
+   // suspect, so it is returned to the caller but not stored. May call the PlainTableCheck, so don't
+   // hold a pooled connection the check might need.
+   void     put(const std::string&                       key,
+                const std::string&                       sql,
+                ResultPtr                                result,
+                uint64_t                                 epoch,
+                std::optional<std::chrono::milliseconds> ttl = std::nullopt);
+   uint64_t writeEpoch() const;
+
+   void invalidateTable(const std::string& table); // empty = unknown table, drops everything
+   void clear();
+
+   // Starts the LISTEN thread on its own connection; reconnects (and clears the cache) after errors
+   void listen(const std::string& conn_str, const std::string& channel);
+
+   Stats stats() const;
+
+   // Deleted operations
+   QueryResultCache(const QueryResultCache&)            = delete;
+   QueryResultCache& operator=(const QueryResultCache&) = delete;
+
+ private:
+   struct Entry {
+      std::string                           key;
+      ResultPtr                             result;
+      size_t                                bytes = 0;
+      std::chrono::steady_clock::time_point expires;
+      std::vector<std::string>              tables;
+      bool                                  any_write = false; // dependencies unknown
+   };
+   using EntryList = std::list<Entry>;
+
+   static size_t estimateBytes(const pqxx::result& result);
+   void          erase(EntryList::iterator it); // caller holds cache_mutex
+   void          listenLoop(std::string conn_str, std::string channel);
+
+   const size_t                    max_bytes;
+   const std::chrono::milliseconds default_ttl;
+   const PlainTableCheck           plain_table; // may be empty
+
+   mutable std::mutex                                               cache_mutex;
+   EntryList                                                        lru;
+   std::unordered_map<std::string, EntryList::iterator>             index;
+   std::unordered_map<std::string, std::unordered_set<std::string>> by_table;  // table -> keys
+   std::unordered_set<std::string>                                  any_write; // keys with unknown dependencies
+   size_t                                                           total_bytes = 0;
+
+   std::atomic<uint64_t> write_epoch{0};
+   std::atomic<uint64_t> hits{0};
+   std::atomic<uint64_t> misses{0};
+   std::atomic<uint64_t> evictions{0};
+   std::atomic<uint64_t> invalidations{0};
+
+   std::thread       listener;
+   std::atomic<bool> stopping{false};
+};
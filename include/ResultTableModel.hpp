@@ -0,0 +1,56 @@
+#ifndef RESULTTABLEMODEL_HPP
+#define RESULTTABLEMODEL_HPP
+
+#include "QueryCursor.hpp"
+#include <QAbstractTableModel>
+#include <memory>
+#include <pqxx/pqxx>
+#include <vector>
+
+QT_BEGIN_NAMESPACE
+class QFontMetrics;
+QT_END_NAMESPACE
+
+// Read-only table model over a pqxx::result. The result stays alive inside the model and cells are
+// converted to QString only when the view asks for them, i.e. for the rows currently on screen.
+// In browse mode the rows come from a QueryCursor instead: the view pulls the next page through
+// fetchMore() as it scrolls, and the cursor (with its pooled connection) is released once it runs
+// dry or the model is given something else to show.
+class ResultTableModel : public QAbstractTableModel {
+   Q_OBJECT
+
+ public:
+   explicit ResultTableModel(QObject* parent = nullptr);
+
+   void setResult(pqxx::result result);
+   void setCursor(std::unique_ptr<QueryCursor> cursor); // fetches the first page right away
+   void clear();
+
+   bool browsing() const; // a cursor is still open
+
+   int      rowCount(const QModelIndex& parent = QModelIndex()) const override;
+   int      columnCount(const QModelIndex& parent = QModelIndex()) const override;
+   QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+   QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+   bool     canFetchMore(const QModelIndex& parent) const override;
+   void     fetchMore(const QModelIndex& parent) override;
+
+   // Pixel widths from the header plus up to `sampleRows` evenly spaced rows, so sizing never
+   // touches every cell the way QHeaderView::ResizeToContents does
+   std::vector<int> estimateColumnWidths(const QFontMetrics& metrics, int sampleRows = 200) const;
+
+ signals:
+   void fetchFailed(const QString& message); // the cursor has been dropped, rows fetched so far stay
+
+ private:
+   pqxx::field cell(int row, int column) const;
+   void        appendPage(pqxx::result page);
+   void        releaseCursor();
+
+   std::vector<pqxx::result>    m_pages;      // one entry outside browse mode
+   std::vector<int>             m_pageStarts; // first row of each page, ascending
+   int                          m_rows = 0;
+   std::unique_ptr<QueryCursor> m_cursor;
+};
+
+#endif // RESULTTABLEMODEL_HPP
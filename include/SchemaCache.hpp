@@ -0,0 +1,71 @@
+// Copyright (c) 2025 Tanner Davison. All Rights Reserved.
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ConnectionPool.hpp"
+
+struct ColumnInfo {
+   std::string name;
+   std::string type;          // format_type() spelling, e.g. "integer", "character varying(50)"
+   std::string default_value; // pg_get_expr() of the default, empty when there is none
+   bool        nullable    = true;
+   bool        has_default = false;
+};
+
+struct TableInfo {
+   std::string             name;
+   char                    kind = 'r'; // pg_class.relkind: 'r' table, 'p' partitioned, 'v' view, 'f' foreign
+   std::vector<ColumnInfo> columns;    // in attnum order
+};
+
+/**
+ * SchemaCache
+ *   Tables and columns of one schema, loaded from pg_catalog in a single query and served from
+ *   memory afterwards. A snapshot is reloaded on the next lookup once it is older than `ttl` or
+ *   after invalidate(); DatabaseManager invalidates it whenever TableCreator runs DDL.
+ *
+ *   Thread-safe. Snapshots are immutable, so lookups only hold the mutex long enough to copy a pointer.
+ */
+class SchemaCache {
+ public:
+   static constexpr std::chrono::milliseconds kDefaultTtl{300000};
+
+   explicit SchemaCache(std::shared_ptr<ConnectionPool> connection_pool,
+                        std::chrono::milliseconds       ttl    = kDefaultTtl, // zero = never expires
+                        std::string                     schema = "public");
+
+   std::vector<std::string>         tables();                        // sorted by name
+   std::shared_ptr<const TableInfo> table(const std::string& name); // nullptr if there is no such table
+
+   void     invalidate(); // next lookup reloads
+   void     refresh();    // reload now
+   uint64_t loads() const;
+
+ private:
+   struct Snapshot {
+      std::vector<std::string>                   table_names;
+      std::unordered_map<std::string, TableInfo> by_name;
+      std::chrono::steady_clock::time_point      loaded_at;
+   };
+
+   std::shared_ptr<const Snapshot> current(); // loads if missing or stale
+   std::shared_ptr<const Snapshot> load();
+
+   std::shared_ptr<ConnectionPool> pool;
+   const std::chrono::milliseconds ttl;
+   const std::string               schema_name;
+
+   mutable std::mutex              snapshot_mutex;
+   std::shared_ptr<const Snapshot> snapshot;
+   uint64_t                        generation = 0; // bumped by invalidate(), guarded by snapshot_mutex
+   std::mutex                      load_mutex;     // one catalog query at a time
+   std::atomic<uint64_t>           load_count{0};
+};
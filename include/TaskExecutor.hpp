@@ -0,0 +1,75 @@
+// Copyright (c) 2025 Tanner Davison. All Rights Reserved.
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * TaskExecutor
+ *   ├─[owns]→ worker threads      (fixed count, started by the constructor)
+ *   └─[owns]→ bounded task queue  (FIFO, guarded by queue_mutex)
+ *
+ * Backpressure: submit() blocks while the queue is full, trySubmit() refuses instead. The destructor
+ * stops accepting work, runs everything already queued and joins the workers.
+ */
+class TaskExecutor {
+ public:
+   TaskExecutor(size_t worker_count, size_t queue_capacity);
+   ~TaskExecutor();
+
+   template <typename F>
+   std::future<std::invoke_result_t<F>> submit(F&& fn) {
+      auto [task, result] = package(std::forward<F>(fn));
+      enqueue(std::move(task), true);
+      return std::move(result);
+   }
+
+   // Never blocks: std::nullopt when the queue is full
+   template <typename F>
+   std::optional<std::future<std::invoke_result_t<F>>> trySubmit(F&& fn) {
+      auto [task, result] = package(std::forward<F>(fn));
+      if (!enqueue(std::move(task), false)) {
+         return std::nullopt;
+      }
+      return std::move(result);
+   }
+
+   size_t workerCount() const;
+   size_t queued() const;
+   size_t capacity() const;
+
+   // Deleted operations
+   TaskExecutor(const TaskExecutor&)            = delete;
+   TaskExecutor& operator=(const TaskExecutor&) = delete;
+
+ private:
+   // std::function needs a copyable target, so the move-only packaged_task rides in a shared_ptr
+   template <typename F>
+   static std::pair<std::function<void()>, std::future<std::invoke_result_t<F>>> package(F&& fn) {
+      using R     = std::invoke_result_t<F>;
+      auto task   = std::make_shared<std::packaged_task<R()>>(std::forward<F>(fn));
+      auto result = task->get_future();
+      return {[task]() { (*task)(); }, std::move(result)};
+   }
+
+   bool enqueue(std::function<void()> task, bool wait); // false if full (and !wait)
+   void workerLoop();
+
+   std::deque<std::function<void()>> tasks;
+   const size_t                      queue_capacity;
+   mutable std::mutex                queue_mutex;
+   std::condition_variable           not_empty;
+   std::condition_variable           not_full;
+   bool                              stopping = false;
+   std::vector<std::thread>          workers;
+};
@@ -0,0 +1,52 @@
+// Copyright (c) 2025 Tanner Davison. All Rights Reserved.
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <pqxx/pqxx>
+
+#include "DataModifier.hpp"
+
+/**
+ * UnitOfWork
+ *   ├─[borrows]→ pqxx::dbtransaction   (opened and committed by DataModifier::transaction)
+ *   └─[uses]→ DataModifier             (statement text, shared statement cache)
+ *
+ * Every insert/update goes to the innermost open transaction, so the whole unit costs one
+ * connection borrow and one commit. savepoint() wraps a step in a SAVEPOINT: a failing step
+ * rolls back only its own changes and the rest of the unit carries on.
+ *
+ * Only valid inside the DataModifier::transaction() body that created it.
+ */
+class UnitOfWork {
+ public:
+   UnitOfWork(DataModifier& modifier, pqxx::dbtransaction& transaction);
+
+   int          insert(const std::string& table, const std::vector<std::string>& columns,
+                       const DataModifier::Row& values);
+   size_t       update(const std::string& table, const std::string& set_column, const std::string& set_value,
+                       const std::string& where_column, const std::string& where_value);
+   pqxx::result exec(const std::string& sql);
+
+   // Runs `step` under its own SAVEPOINT. Returns false (and the reason in *error) if it threw;
+   // a lost connection is not isolated and still propagates.
+   bool savepoint(const std::function<void(UnitOfWork& work)>& step, std::string* error = nullptr);
+
+   pqxx::transaction_base&      transaction(); // innermost open (sub)transaction
+   size_t                       failedSavepoints() const;
+   const std::set<std::string>& touchedTables() const; // "" = exec() ran, could have been anything
+
+   // Deleted operations
+   UnitOfWork(const UnitOfWork&)            = delete;
+   UnitOfWork& operator=(const UnitOfWork&) = delete;
+
+ private:
+   DataModifier&         data;
+   pqxx::dbtransaction*  active; // the root transaction or the current savepoint
+   size_t                failures = 0;
+   std::set<std::string> touched; // reported to change listeners after commit
+};
@@ -0,0 +1,416 @@
+#include "ColumnarResult.hpp"
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstdlib>
+#include <exception>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+// Built-in type OIDs from pg_type.dat; these never change between server versions
+constexpr pqxx::oid kBoolOid        = 16;
+constexpr pqxx::oid kInt8Oid        = 20;
+constexpr pqxx::oid kInt2Oid        = 21;
+constexpr pqxx::oid kInt4Oid        = 23;
+constexpr pqxx::oid kOidOid         = 26;
+constexpr pqxx::oid kFloat4Oid      = 700;
+constexpr pqxx::oid kFloat8Oid      = 701;
+constexpr pqxx::oid kDateOid        = 1082;
+constexpr pqxx::oid kTimestampOid   = 1114;
+constexpr pqxx::oid kTimestampTzOid = 1184;
+constexpr pqxx::oid kNumericOid     = 1700;
+
+const char* typeName(ColumnarResult::Type type) {
+   switch (type) {
+      case ColumnarResult::Type::Int64:
+         return "int64";
+      case ColumnarResult::Type::Float64:
+         return "float64";
+      case ColumnarResult::Type::Bool:
+         return "bool";
+      case ColumnarResult::Type::Timestamp:
+         return "timestamp";
+      case ColumnarResult::Type::Text:
+         return "text";
+   }
+   return "unknown";
+}
+
+[[noreturn]] void parseError(const ColumnarResult::Column& column, std::string_view value) {
+   throw std::runtime_error("ColumnarResult: cannot read '" + std::string(value) + "' as " + typeName(column.type) +
+                            " in column " + column.name);
+}
+
+bool parseInt(std::string_view text, int64_t& out) {
+   const char* end = text.data() + text.size();
+   auto [ptr, ec]  = std::from_chars(text.data(), end, out);
+   return ec == std::errc() && ptr == end;
+}
+
+bool parseDouble(std::string_view text, double& out) {
+   const char* end = text.data() + text.size();
+   auto [ptr, ec]  = std::from_chars(text.data(), end, out);
+   if (ec == std::errc::result_out_of_range && ptr == end) {
+      // numeric can exceed double's range; strtod saturates to +-HUGE_VAL or rounds to zero
+      out = std::strtod(std::string(text).c_str(), nullptr);
+      return true;
+   }
+   return ec == std::errc() && ptr == end;
+}
+
+// Howard Hinnant's days_from_civil: proleptic Gregorian date -> days since 1970-01-01
+int64_t daysFromCivil(int64_t year, unsigned month, unsigned day) {
+   year -= month <= 2;
+   const int64_t  era = (year >= 0 ? year : year - 399) / 400;
+   const unsigned yoe = static_cast<unsigned>(year - era * 400);
+   const unsigned doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+   const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+   return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+
+bool digits(const char*& p, const char* end, int count, unsigned& out) {
+   out = 0;
+   for (int i = 0; i < count; ++i, ++p) {
+      if (p == end || *p < '0' || *p > '9') {
+         return false;
+      }
+      out = out * 10 + static_cast<unsigned>(*p - '0');
+   }
+   return true;
+}
+
+bool expect(const char*& p, const char* end, char c) {
+   if (p == end || *p != c) {
+      return false;
+   }
+   ++p;
+   return true;
+}
+
+// ISO DateStyle output: YYYY-MM-DD[ HH:MM:SS[.ffffff][+-HH[:MM[:SS]]]][ BC], or +-infinity
+bool parseTimestamp(std::string_view text, int64_t& micros) {
+   if (text == "infinity") {
+      micros = std::numeric_limits<int64_t>::max();
+      return true;
+   }
+   if (text == "-infinity") {
+      micros = std::numeric_limits<int64_t>::min();
+      return true;
+   }
+
+   bool before_christ = text.size() > 3 && text.substr(text.size() - 3) == " BC";
+   if (before_christ) {
+      text.remove_suffix(3);
+   }
+
+   const char* p   = text.data();
+   const char* end = p + text.size();
+   int64_t     year;
+   auto [ptr, ec] = std::from_chars(p, end, year);
+   if (ec != std::errc() || ptr == p) {
+      return false;
+   }
+   p = ptr;
+
+   unsigned month, day;
+   if (!expect(p, end, '-') || !digits(p, end, 2, month) || !expect(p, end, '-') || !digits(p, end, 2, day)) {
+      return false;
+   }
+   if (before_christ) {
+      year = 1 - year; // there is no year 0: 1 BC is astronomical year 0
+   }
+
+   int64_t seconds  = daysFromCivil(year, month, day) * 86400;
+   int64_t fraction = 0;
+   if (p != end) {
+      unsigned hours, minutes, secs;
+      if ((*p != ' ' && *p != 'T') || !digits(++p, end, 2, hours) || !expect(p, end, ':') ||
+          !digits(p, end, 2, minutes) || !expect(p, end, ':') || !digits(p, end, 2, secs)) {
+         return false;
+      }
+      seconds += hours * 3600 + minutes * 60 + secs;
+
+      if (p != end && *p == '.') {
+         int64_t scale = 100000;
+         for (++p; p != end && *p >= '0' && *p <= '9'; ++p, scale /= 10) {
+            fraction += (*p - '0') * scale;
+         }
+      }
+      if (p != end && (*p == '+' || *p == '-')) {
+         const int64_t sign = *p++ == '+' ? 1 : -1;
+         unsigned      off_hours, off_minutes = 0, off_seconds = 0;
+         if (!digits(p, end, 2, off_hours) ||
+             (p != end && *p == ':' && !digits(++p, end, 2, off_minutes)) ||
+             (p != end && *p == ':' && !digits(++p, end, 2, off_seconds))) {
+            return false;
+         }
+         seconds -= sign * (off_hours * 3600 + off_minutes * 60 + off_seconds);
+      }
+   }
+   if (p != end) {
+      return false;
+   }
+   micros = seconds * 1000000 + fraction;
+   return true;
+}
+
+void checkArena(const std::string& arena) {
+   if (arena.size() > std::numeric_limits<uint32_t>::max()) {
+      throw std::length_error("ColumnarResult: text column exceeds 4 GiB");
+   }
+}
+} // namespace
+
+/* <----------------------------- Column ----------------------------->*/
+
+bool ColumnarResult::Column::isNull(size_t row) const {
+   return (nulls[row / 64] >> (row % 64)) & 1;
+}
+
+std::string_view ColumnarResult::Column::text(size_t row) const {
+   if (isNull(row)) {
+      return {};
+   }
+   const size_t value = dictionary ? codes[row] : row;
+   return std::string_view(arena.data() + offsets[value], offsets[value + 1] - offsets[value]);
+}
+
+size_t ColumnarResult::Column::dictionarySize() const {
+   return dictionary ? offsets.size() - 1 : 0;
+}
+
+size_t ColumnarResult::Column::memoryBytes() const {
+   return nulls.capacity() * sizeof(uint64_t) + ints.capacity() * sizeof(int64_t) +
+          doubles.capacity() * sizeof(double) + bools.capacity() + arena.capacity() +
+          offsets.capacity() * sizeof(uint32_t) + codes.capacity() * sizeof(uint32_t);
+}
+
+/* <-------------------------- ColumnarResult -------------------------->*/
+
+ColumnarResult::ColumnarResult(const ColumnarOptions& opts) : options(opts) {}
+
+ColumnarResult ColumnarResult::from(const pqxx::result& result, const ColumnarOptions& options) {
+   ColumnarResult columnar(options);
+   columnar.append(result);
+   return columnar;
+}
+
+ColumnarResult::Type ColumnarResult::typeForOid(pqxx::oid oid) {
+   switch (oid) {
+      case kInt2Oid:
+      case kInt4Oid:
+      case kInt8Oid:
+      case kOidOid:
+         return Type::Int64;
+      case kFloat4Oid:
+      case kFloat8Oid:
+      case kNumericOid:
+         return Type::Float64;
+      case kBoolOid:
+         return Type::Bool;
+      case kDateOid:
+      case kTimestampOid:
+      case kTimestampTzOid:
+         return Type::Timestamp;
+      default:
+         return Type::Text;
+   }
+}
+
+void ColumnarResult::append(const pqxx::result& page) {
+   const size_t width = static_cast<size_t>(page.columns());
+   if (column_data.empty()) {
+      column_data.resize(width);
+      dictionaries.resize(width);
+      for (size_t i = 0; i < width; ++i) {
+         Column& column    = column_data[i];
+         column.name       = page.column_name(static_cast<int>(i));
+         column.oid        = page.column_type(static_cast<int>(i));
+         column.type       = typeForOid(column.oid);
+         column.dictionary = column.type == Type::Text && options.dictionary_max_distinct > 0;
+      }
+   } else if (width != column_data.size()) {
+      throw std::invalid_argument("ColumnarResult: page has " + std::to_string(width) + " columns, expected " +
+                                  std::to_string(column_data.size()));
+   }
+
+   size_t threads = options.max_threads ? options.max_threads : std::thread::hardware_concurrency();
+   threads        = std::min(threads, width);
+   if (threads <= 1 || static_cast<size_t>(page.size()) * width < options.parallel_threshold) {
+      for (size_t i = 0; i < width; ++i) {
+         appendColumn(i, page);
+      }
+   } else {
+      // Columns are independent, so each worker claims whole columns and never shares a vector
+      std::atomic<size_t>             next{0};
+      std::vector<std::exception_ptr> errors(width);
+      std::vector<std::thread>        workers;
+      workers.reserve(threads);
+      for (size_t t = 0; t < threads; ++t) {
+         workers.emplace_back([&] {
+            for (size_t i = next.fetch_add(1); i < width; i = next.fetch_add(1)) {
+               try {
+                  appendColumn(i, page);
+               } catch (...) {
+                  errors[i] = std::current_exception();
+               }
+            }
+         });
+      }
+      for (auto& worker : workers) {
+         worker.join();
+      }
+      for (const auto& error : errors) {
+         if (error) {
+            std::rethrow_exception(error);
+         }
+      }
+   }
+   row_count += static_cast<size_t>(page.size());
+}
+
+void ColumnarResult::appendColumn(size_t index, const pqxx::result& page) {
+   Column&      column = column_data[index];
+   const int    col    = static_cast<int>(index);
+   const size_t added  = static_cast<size_t>(page.size());
+
+   column.nulls.resize((column.rows + added + 63) / 64, 0);
+   switch (column.type) {
+      case Type::Int64:
+      case Type::Timestamp:
+         column.ints.reserve(column.rows + added);
+         break;
+      case Type::Float64:
+         column.doubles.reserve(column.rows + added);
+         break;
+      case Type::Bool:
+         column.bools.reserve(column.rows + added);
+         break;
+      case Type::Text:
+         (column.dictionary ? column.codes : column.offsets).reserve(column.rows + added + 1);
+         break;
+   }
+
+   for (const auto& row : page) {
+      const pqxx::field field = row[col];
+      const size_t      r     = column.rows++;
+      const bool        null  = field.is_null();
+      if (null) {
+         column.nulls[r / 64] |= uint64_t{1} << (r % 64);
+      }
+      const std::string_view value = null ? std::string_view() : std::string_view(field.c_str(), field.size());
+
+      switch (column.type) {
+         case Type::Int64: {
+            int64_t parsed = 0;
+            if (!null && !parseInt(value, parsed)) {
+               parseError(column, value);
+            }
+            column.ints.push_back(parsed);
+            break;
+         }
+         case Type::Timestamp: {
+            int64_t parsed = 0;
+            if (!null && !parseTimestamp(value, parsed)) {
+               parseError(column, value);
+            }
+            column.ints.push_back(parsed);
+            break;
+         }
+         case Type::Float64: {
+            double parsed = 0.0;
+            if (!null && !parseDouble(value, parsed)) {
+               parseError(column, value);
+            }
+            column.doubles.push_back(parsed);
+            break;
+         }
+         case Type::Bool:
+            if (!null && value != "t" && value != "f") {
+               parseError(column, value);
+            }
+            column.bools.push_back(!null && value == "t");
+            break;
+         case Type::Text:
+            if (null && column.dictionary) {
+               column.codes.push_back(0); // never read: text() checks the bitmap first
+            } else {
+               appendText(column, dictionaries[index], value);
+            }
+            break;
+      }
+   }
+}
+
+void ColumnarResult::appendText(Column&                                   column,
+                                std::unordered_map<std::string, uint32_t>& dictionary,
+                                std::string_view                          value) {
+   if (column.dictionary) {
+      auto it = dictionary.find(std::string(value));
+      if (it == dictionary.end() && dictionary.size() >= options.dictionary_max_distinct) {
+         dropDictionary(column, dictionary); // too many distinct values to pay off
+      } else {
+         if (it == dictionary.end()) {
+            it = dictionary.emplace(std::string(value), static_cast<uint32_t>(dictionary.size())).first;
+            column.arena.append(value);
+            checkArena(column.arena);
+            column.offsets.push_back(static_cast<uint32_t>(column.arena.size()));
+         }
+         column.codes.push_back(it->second);
+         return;
+      }
+   }
+   column.arena.append(value);
+   checkArena(column.arena);
+   column.offsets.push_back(static_cast<uint32_t>(column.arena.size()));
+}
+
+void ColumnarResult::dropDictionary(Column& column, std::unordered_map<std::string, uint32_t>& dictionary) {
+   std::string           arena;
+   std::vector<uint32_t> offsets{0};
+   offsets.reserve(column.rows + 1);
+   for (size_t r = 0; r < column.codes.size(); ++r) {
+      if (!column.isNull(r)) {
+         const uint32_t code = column.codes[r];
+         arena.append(column.arena, column.offsets[code], column.offsets[code + 1] - column.offsets[code]);
+         checkArena(arena);
+      }
+      offsets.push_back(static_cast<uint32_t>(arena.size()));
+   }
+   column.arena   = std::move(arena);
+   column.offsets = std::move(offsets);
+   std::vector<uint32_t>().swap(column.codes);
+   std::unordered_map<std::string, uint32_t>().swap(dictionary);
+   column.dictionary = false;
+}
+
+size_t ColumnarResult::rows() const {
+   return row_count;
+}
+
+size_t ColumnarResult::columnCount() const {
+   return column_data.size();
+}
+
+const ColumnarResult::Column& ColumnarResult::column(size_t index) const {
+   return column_data.at(index);
+}
+
+const ColumnarResult::Column& ColumnarResult::column(std::string_view name) const {
+   for (const auto& column : column_data) {
+      if (column.name == name) {
+         return column;
+      }
+   }
+   throw std::out_of_range("ColumnarResult: no column named " + std::string(name));
+}
+
+size_t ColumnarResult::memoryBytes() const {
+   size_t bytes = 0;
+   for (const auto& column : column_data) {
+      bytes += column.memoryBytes();
+   }
+   return bytes;
+}
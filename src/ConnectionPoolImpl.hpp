@@ -0,0 +1,704 @@
+// Copyright (c) 2025 Tanner Davison. All Rights Reserved.
+#pragma once
+
+// Member definitions of BasicConnectionPool. Only translation units that instantiate a pool include this:
+// ConnectionPool.cpp for pqxx::connection, pgpool_bench for its mock connection.
+
+#include "ConnectionPool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+template <typename Connection, typename Traits>
+size_t BasicConnectionPool<Connection, Traits>::resolveShardCount(const PoolOptions& options) {
+   size_t count = options.shards;
+   if (count == 0) {
+      count = std::max<size_t>(1, std::thread::hardware_concurrency());
+   }
+   return std::max<size_t>(1, std::min(count, options.max_connections));
+}
+
+template <typename Connection, typename Traits>
+BasicConnectionPool<Connection, Traits>::BasicConnectionPool(const std::string& conn_str,
+                                                             size_t             min_conns,
+                                                             size_t             max_conns)
+    : BasicConnectionPool(conn_str, PoolOptions{min_conns, max_conns}) {}
+
+template <typename Connection, typename Traits>
+BasicConnectionPool<Connection, Traits>::BasicConnectionPool(const std::string& conn_str, const PoolOptions& options)
+    : connections(options.max_connections)
+    , next_free(std::make_unique<std::atomic<uint32_t>[]>(options.max_connections))
+    , shard_count(resolveShardCount(options))
+    , spin_limit(std::thread::hardware_concurrency() > 1 ? kSpinLimit : 0)
+    , shards(std::make_unique<Shard[]>(shard_count))
+    , connection_string(conn_str)
+    , max_connections(options.max_connections)
+    , min_connections(options.min_connections)
+    , idle_timeout(options.idle_timeout)
+    , max_lifetime(options.max_lifetime)
+    , max_uses(options.max_uses)
+    , maintenance_interval(std::max(options.maintenance_interval, std::chrono::milliseconds(10)))
+    , validate_after_idle(options.validate_after_idle)
+    , statement_cache_size(options.statement_cache_size) {
+   if (max_connections == 0 || max_connections >= kNoIndex || min_connections > max_connections) {
+      throw std::invalid_argument("Pool size must satisfy 0 <= min_connections <= max_connections, max > 0");
+   }
+   empty_slots.reserve(max_connections);
+   for (size_t slot = max_connections; slot-- > 0;) { // low slots are handed out first
+      empty_slots.push_back(slot);
+   }
+
+   warmUp(options);
+   maintenance_thread = std::thread(&BasicConnectionPool::maintenanceLoop, this);
+
+   std::cout << "Connection pool initialized with " << (options.warmup_async ? totalConnections() : min_connections)
+             << " connections";
+   if (shard_count > 1) {
+      std::cout << " across " << shard_count << " shards";
+   }
+   if (options.warmup_async) {
+      std::cout << " (" << min_connections << " warming up in background)";
+   }
+   std::cout << std::endl;
+}
+
+template <typename Connection, typename Traits>
+BasicConnectionPool<Connection, Traits>::~BasicConnectionPool() {
+   {
+      std::lock_guard<std::mutex> lock(maint_mutex);
+      stopping = true;
+   }
+   maint_cv.notify_all();
+   if (maintenance_thread.joinable()) {
+      maintenance_thread.join();
+   }
+   for (auto& worker : warmup_threads) {
+      if (worker.joinable()) {
+         worker.join();
+      }
+   }
+}
+
+// Opens min_connections on a few threads at once instead of one handshake after another.
+// Workers pull reserved slots off a shared counter; the constructor waits for all of them, or only
+// for the first success when warmup_async is set.
+template <typename Connection, typename Traits>
+void BasicConnectionPool<Connection, Traits>::warmUp(const PoolOptions& options) {
+   if (min_connections == 0) {
+      return;
+   }
+
+   struct WarmupState {
+      std::vector<size_t>                   slots;
+      std::atomic<size_t>                   next{0};
+      std::mutex                            mutex;
+      std::condition_variable               cv;
+      size_t                                opened   = 0;
+      size_t                                finished = 0;
+      std::exception_ptr                    first_error;
+      std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+   };
+   auto state = std::make_shared<WarmupState>(); // shared with workers that outlive the constructor
+   state->slots.resize(min_connections);
+   {
+      std::lock_guard<std::mutex> lock(pool_mutex);
+      for (auto& slot : state->slots) {
+         reserveSlot(slot);
+      }
+   }
+
+   auto worker = [this, state] {
+      const size_t count = state->slots.size();
+      for (size_t i; (i = state->next.fetch_add(1)) < count;) {
+         auto start = std::chrono::steady_clock::now();
+         bool ok    = false;
+         try {
+            size_t slot    = createConnection(state->slots[i]);
+            auto   latency = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() -
+                                                                                   start);
+            {
+               std::lock_guard<std::mutex> lock(warmup_mutex);
+               warmup_latencies.push_back(latency);
+            }
+            publishIdle(slot, i % shard_count); // deal round-robin so every shard starts with some
+            ok = true;
+         } catch (const std::exception& e) {
+            std::cerr << "Connection pool warm-up: connect failed: " << e.what() << std::endl;
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (!state->first_error) {
+               state->first_error = std::current_exception();
+            }
+         }
+
+         std::lock_guard<std::mutex> lock(state->mutex);
+         state->opened += ok ? 1 : 0;
+         if (++state->finished == count) {
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() -
+                                                                                 state->started);
+            std::chrono::milliseconds slowest{0};
+            for (auto latency : warmupLatencies()) {
+               slowest = std::max(slowest, latency);
+            }
+            std::cout << "Connection pool warm-up: " << state->opened << "/" << count << " connections in "
+                      << elapsed.count() << " ms (slowest connect " << slowest.count() << " ms)" << std::endl;
+         }
+         state->cv.notify_all();
+      }
+   };
+
+   size_t workers = std::clamp<size_t>(options.warmup_parallelism, 1, min_connections);
+   for (size_t w = 0; w < workers; ++w) {
+      warmup_threads.emplace_back(worker);
+   }
+
+   std::unique_lock<std::mutex> lock(state->mutex);
+   state->cv.wait(lock, [&] {
+      return state->finished == state->slots.size() || (options.warmup_async && state->opened > 0);
+   });
+   // synchronous warm-up keeps the old contract that every initial connection must succeed
+   bool failed = options.warmup_async ? state->opened == 0 : state->first_error != nullptr;
+   lock.unlock();
+
+   if (failed || !options.warmup_async) {
+      for (auto& thread : warmup_threads) {
+         thread.join();
+      }
+      warmup_threads.clear();
+   }
+   if (failed) {
+      std::rethrow_exception(state->first_error);
+   }
+}
+
+template <typename Connection, typename Traits>
+std::vector<std::chrono::milliseconds> BasicConnectionPool<Connection, Traits>::warmupLatencies() const {
+   std::lock_guard<std::mutex> lock(warmup_mutex);
+   return warmup_latencies;
+}
+
+template <typename Connection, typename Traits>
+bool BasicConnectionPool<Connection, Traits>::reserveSlot(size_t& slot) {
+   if (empty_slots.empty()) {
+      return false;
+   }
+   slot = empty_slots.back();
+   empty_slots.pop_back();
+   reserved_count.fetch_add(1);
+   return true;
+}
+
+template <typename Connection, typename Traits>
+void BasicConnectionPool<Connection, Traits>::releaseSlot(size_t slot) {
+   std::lock_guard<std::mutex> lock(pool_mutex);
+   empty_slots.push_back(slot);
+   reserved_count.fetch_sub(1);
+   dispatchWaiters(); // the oldest waiter may now grow into this slot
+}
+
+// Serves queued waiters in arrival order: spare capacity always, idle connections only while a handoff
+// is owed. Otherwise an idle connection just wakes the head to compete for it like any other borrower.
+template <typename Connection, typename Traits>
+void BasicConnectionPool<Connection, Traits>::dispatchWaiters() {
+   while (!wait_queue.empty()) {
+      Waiter* waiter = wait_queue.front();
+      size_t  slot;
+      if (handoff.load() && popFree(slot)) {
+         waiter->granted = true;
+      } else if (reserveSlot(slot)) {
+         waiter->grow = true;
+      } else {
+         if (!handoff.load() && anyFree() && !waking.exchange(true)) {
+            wakeHead();
+         }
+         return;
+      }
+      if (waiter->woken) {
+         waiter->woken = false;
+         waking.store(false);
+      }
+      waiter->slot = slot;
+      wait_queue.pop_front();
+      waiter->cv.notify_one();
+      updateHandoff();
+   }
+}
+
+template <typename Connection, typename Traits>
+void BasicConnectionPool<Connection, Traits>::wakeHead() {
+   if (wait_queue.empty()) {
+      waking.store(false);
+      return;
+   }
+   wait_queue.front()->woken = true;
+   wait_queue.front()->cv.notify_one();
+}
+
+// Handoff lasts while the queue head has been parked past kHandoffAfter, so it ends once the waiters
+// that were starved are served, not when the queue drains, which under overload it never does.
+template <typename Connection, typename Traits>
+void BasicConnectionPool<Connection, Traits>::updateHandoff() {
+   handoff.store(!wait_queue.empty() &&
+                 std::chrono::steady_clock::now() - wait_queue.front()->parked_at >= kHandoffAfter);
+}
+
+template <typename Connection, typename Traits>
+bool BasicConnectionPool<Connection, Traits>::anyFree() const {
+   for (size_t i = 0; i < shard_count; ++i) {
+      if (static_cast<uint32_t>(shards[i].free_head.load()) != kNoIndex) {
+         return true;
+      }
+   }
+   return false;
+}
+
+template <typename Connection, typename Traits>
+size_t BasicConnectionPool<Connection, Traits>::createConnection(size_t slot) {
+   // the slot is ours alone until it is published, so the handshake runs without any lock
+   try {
+      connections[slot].conn       = Traits::connect(connection_string);
+      connections[slot].statements = Traits::attachStatements(*connections[slot].conn, statement_cache_size);
+   } catch (...) {
+      creation_failures.fetch_add(1, std::memory_order_relaxed);
+      releaseSlot(slot);
+      throw;
+   }
+   connections[slot].created_at = std::chrono::steady_clock::now();
+   connections[slot].last_used  = connections[slot].created_at;
+   connections[slot].use_count  = 0;
+   connections[slot].in_use     = false;
+   total_count.fetch_add(1);
+   creations.fetch_add(1, std::memory_order_relaxed);
+   return slot;
+}
+
+// Shard for the calling thread: the CPU it is running on where we can ask cheaply, otherwise a
+// sticky per-thread assignment. Either way it is only a locality hint, correctness never depends on it.
+template <typename Connection, typename Traits>
+size_t BasicConnectionPool<Connection, Traits>::localShard() const {
+   if (shard_count == 1) {
+      return 0;
+   }
+#ifdef __linux__
+   int cpu = sched_getcpu();
+   if (cpu >= 0) {
+      return static_cast<size_t>(cpu) % shard_count;
+   }
+#endif
+   static std::atomic<size_t> next_thread{0};
+   thread_local size_t        thread_slot = next_thread.fetch_add(1);
+   return thread_slot % shard_count;
+}
+
+// Treiber stack pop. The tag in the upper half of free_head changes on every update, so a slot
+// that is popped and pushed back between our load and CAS can't be mistaken for the old head (ABA).
+template <typename Connection, typename Traits>
+bool BasicConnectionPool<Connection, Traits>::popShard(Shard& shard, size_t& index) {
+   uint64_t head = shard.free_head.load();
+   while (static_cast<uint32_t>(head) != kNoIndex) {
+      uint32_t top  = static_cast<uint32_t>(head);
+      uint32_t next = next_free[top].load(std::memory_order_relaxed);
+      uint64_t tag  = (head >> 32) + 1;
+      if (shard.free_head.compare_exchange_weak(head, (tag << 32) | next)) {
+         shard.idle.fetch_sub(1, std::memory_order_relaxed);
+         index = top;
+         return true;
+      }
+   }
+   return false;
+}
+
+template <typename Connection, typename Traits>
+bool BasicConnectionPool<Connection, Traits>::popFree(size_t& index) {
+   size_t home = localShard();
+   for (size_t i = 0; i < shard_count; ++i) { // i == 0 is the local shard, the rest is stealing
+      if (popShard(shards[(home + i) % shard_count], index)) {
+         return true;
+      }
+   }
+   return false;
+}
+
+template <typename Connection, typename Traits>
+void BasicConnectionPool<Connection, Traits>::pushFree(size_t index, size_t shard) {
+   Shard&   target = shards[shard];
+   uint64_t head   = target.free_head.load();
+   uint64_t desired;
+   do {
+      next_free[index].store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+      desired = (((head >> 32) + 1) << 32) | static_cast<uint32_t>(index);
+   } while (!target.free_head.compare_exchange_weak(head, desired));
+   target.idle.fetch_add(1, std::memory_order_relaxed);
+}
+
+// ConnectionHandle consturctor
+template <typename Connection, typename Traits>
+BasicConnectionPool<Connection, Traits>::ConnectionHandle::ConnectionHandle(
+    Connection* c, BasicConnectionPool* p, size_t idx, std::chrono::steady_clock::time_point acquired)
+    : conn(c), pool(p), index(idx), acquired_at(acquired) {}
+
+// ConnectionHandle  move constructor
+template <typename Connection, typename Traits>
+BasicConnectionPool<Connection, Traits>::ConnectionHandle::ConnectionHandle(ConnectionHandle&& other) noexcept
+    : conn(other.conn)
+    , pool(other.pool)
+    , index(other.index)
+    , broken(other.broken)
+    , acquired_at(other.acquired_at) {
+   other.conn = nullptr;
+   other.pool = nullptr;
+};
+
+template <typename Connection, typename Traits>
+void BasicConnectionPool<Connection, Traits>::publishIdle(size_t index, size_t shard) {
+   pushFree(index, shard);
+
+   // A waiter bumps `waiters` before re-checking the free list under pool_mutex, so either it sees
+   // our push or we see it waiting. Even then the lock is only paid for a handoff, or to wake a waiter
+   // when none is awake already; a woken waiter clears `waking` before its next look at the free list.
+   if (waiters.load() == 0) {
+      return;
+   }
+   if (handoff.load()) {
+      std::lock_guard<std::mutex> lock(pool_mutex);
+      dispatchWaiters();
+   } else if (!waking.exchange(true)) {
+      std::lock_guard<std::mutex> lock(pool_mutex);
+      wakeHead();
+   }
+}
+
+template <typename Connection, typename Traits>
+void BasicConnectionPool<Connection, Traits>::returnConnection(size_t                                index,
+                                                               bool                                  broken,
+                                                               std::chrono::steady_clock::time_point acquired_at) {
+   auto& pooled     = connections[index];
+   pooled.in_use    = false;
+   pooled.last_used = std::chrono::steady_clock::now();
+   hold_time.record(pooled.last_used - acquired_at);
+   if (broken) {
+      broken_evictions.fetch_add(1, std::memory_order_relaxed);
+   }
+   if (broken || expired(pooled, pooled.last_used)) {
+      retire(index);
+      return;
+   }
+   publishIdle(index, localShard()); // returned connections migrate to the shard that used them last
+}
+
+template <typename Connection, typename Traits>
+auto BasicConnectionPool<Connection, Traits>::ConnectionHandle::statements() -> StatementCache& {
+   return *pool->connections[index].statements;
+}
+
+template <typename Connection, typename Traits>
+BasicConnectionPool<Connection, Traits>::ConnectionHandle::~ConnectionHandle() {
+   if (pool && conn) {
+      pool->returnConnection(index, broken || !Traits::isOpen(*conn), acquired_at);
+   }
+}
+
+template <typename Connection, typename Traits>
+auto BasicConnectionPool<Connection, Traits>::lend(size_t                                index,
+                                                   std::chrono::steady_clock::time_point requested,
+                                                   std::chrono::steady_clock::time_point granted) -> ConnectionHandle {
+   acquire_wait.record(granted - requested);
+   connections[index].in_use = true;
+   ++connections[index].use_count;
+   return ConnectionHandle(connections[index].conn.get(), this, index, granted);
+}
+
+template <typename Connection, typename Traits>
+auto BasicConnectionPool<Connection, Traits>::getConnection() -> ConnectionHandle { // Returns a ConnectionHandle
+   return acquire(std::nullopt);
+}
+
+template <typename Connection, typename Traits>
+auto BasicConnectionPool<Connection, Traits>::tryGetConnection() -> std::optional<ConnectionHandle> {
+   // atomics only. Queued waiters don't stop us, only a waiter that is owed a handoff does. Nothing here
+   // waits, so one clock read is both the request and the grant time.
+   size_t index;
+   while (!handoff.load(std::memory_order_relaxed) && popFree(index)) {
+      auto now = std::chrono::steady_clock::now();
+      if (healthy(index, now)) {
+         return lend(index, now, now);
+      }
+      broken_evictions.fetch_add(1, std::memory_order_relaxed);
+      retire(index);
+   }
+   return std::nullopt;
+}
+
+template <typename Connection, typename Traits>
+auto BasicConnectionPool<Connection, Traits>::acquire(std::optional<std::chrono::steady_clock::time_point> deadline)
+    -> ConnectionHandle {
+   if (auto handle = tryGetConnection()) { // fast path
+      return std::move(*handle);
+   }
+   // dead connections are evicted for the maintenance thread to replace, and we simply try again
+   auto requested = std::chrono::steady_clock::now();
+   for (;;) {
+      bool   fresh   = false;
+      size_t index   = take(deadline, fresh);
+      auto   granted = std::chrono::steady_clock::now();
+      if (fresh || healthy(index, granted)) {
+         return lend(index, requested, granted);
+      }
+      broken_evictions.fetch_add(1, std::memory_order_relaxed);
+      retire(index);
+   }
+}
+
+// Checks a connection that has been sitting idle before lending it out. isOpen() is free; the
+// round trip is only paid once the connection has been idle past validate_after_idle.
+template <typename Connection, typename Traits>
+bool BasicConnectionPool<Connection, Traits>::healthy(size_t index, std::chrono::steady_clock::time_point now) {
+   auto& pooled = connections[index];
+   if (!Traits::isOpen(*pooled.conn)) {
+      return false;
+   }
+   if (validate_after_idle.count() == 0 || now - pooled.last_used < validate_after_idle) {
+      return true;
+   }
+   try {
+      Traits::ping(*pooled.conn);
+      return true;
+   } catch (const std::exception& e) {
+      std::cerr << "Connection pool: evicting broken connection: " << e.what() << std::endl;
+      return false;
+   }
+}
+
+// Produces a slot index: an idle connection, or (fresh == true) a connection we just opened.
+template <typename Connection, typename Traits>
+size_t BasicConnectionPool<Connection, Traits>::take(std::optional<std::chrono::steady_clock::time_point> deadline,
+                                                     bool&                                                fresh) {
+   size_t index;
+
+   // tryGetConnection() came up empty. At capacity, spin briefly before parking: most holds are short.
+   if (reserved_count.load() >= max_connections) {
+      for (int spin = 0; spin < spin_limit && !handoff.load(std::memory_order_relaxed); ++spin) {
+         if (popFree(index)) {
+            return index;
+         }
+         std::this_thread::yield();
+      }
+   }
+
+   // slow path: grow into a free slot, or queue up until we win an idle connection or one is handed to us
+   std::unique_lock<std::mutex> lock(pool_mutex);
+   size_t now_waiting = waiters.fetch_add(1) + 1;
+   if (peak_waiters.load(std::memory_order_relaxed) < now_waiting) {
+      peak_waiters.store(now_waiting, std::memory_order_relaxed); // only ever written under pool_mutex
+   }
+   Waiter self;
+   self.parked_at = std::chrono::steady_clock::now();
+   bool queued    = false;
+   bool took      = false; // popped the free list ourselves rather than being served by dispatchWaiters()
+   for (;;) {
+      if (self.granted || self.grow) {
+         break; // dispatchWaiters() served us, possibly from our own call below, and took us off the queue
+      }
+      if (self.woken) {
+         self.woken = false;
+         waking.store(false); // before the pop, so a return that saw `waking` set is visible to it
+      }
+      if (!handoff.load() && popFree(self.slot)) {
+         self.granted = took = true;
+         break;
+      }
+      if (!queued) {
+         if (wait_queue.empty() && reserveSlot(self.slot)) {
+            self.grow = true;
+            break;
+         }
+         exhaustion_events.fetch_add(1, std::memory_order_relaxed);
+         wait_queue.push_back(&self);
+         queued = true;
+      }
+
+      auto handoff_at = self.parked_at + kHandoffAfter;
+      auto wake_at    = deadline;
+      if (!handoff.load()) {
+         wake_at = deadline ? std::min(*deadline, handoff_at) : handoff_at;
+      }
+      if (wake_at) {
+         self.cv.wait_until(lock, *wake_at);
+      } else {
+         self.cv.wait(lock);
+      }
+
+      if (self.granted || self.grow) {
+         continue; // served while we slept
+      }
+      auto now = std::chrono::steady_clock::now();
+      if (deadline && now >= *deadline) {
+         wait_queue.erase(std::find(wait_queue.begin(), wait_queue.end(), &self));
+         if (self.woken) {
+            waking.store(false);
+         }
+         waiters.fetch_sub(1);
+         timeouts.fetch_add(1, std::memory_order_relaxed);
+         updateHandoff();
+         dispatchWaiters(); // pass on anything we were woken for
+         throw PoolTimeoutError("Timed out waiting for a database connection (" + std::to_string(max_connections) +
+                                " in use)");
+      }
+      if (!handoff.load() && now >= handoff_at) {
+         handoff.store(true); // we have lost to barging borrowers long enough
+         dispatchWaiters();
+      }
+   }
+   if (took && queued) {
+      wait_queue.erase(std::find(wait_queue.begin(), wait_queue.end(), &self));
+      dispatchWaiters(); // another idle connection may be waiting for the next in line
+   }
+   waiters.fetch_sub(1);
+   lock.unlock();
+
+   if (self.granted) {
+      return self.slot;
+   }
+   fresh = true;
+   return createConnection(self.slot);
+}
+
+template <typename Connection, typename Traits>
+size_t BasicConnectionPool<Connection, Traits>::activeConnections() const {
+   int64_t idle = 0;
+   for (size_t i = 0; i < shard_count; ++i) {
+      idle += shards[i].idle.load(std::memory_order_relaxed);
+   }
+   int64_t total = static_cast<int64_t>(total_count.load());
+   return static_cast<size_t>(std::clamp<int64_t>(total - idle, 0, total));
+}
+template <typename Connection, typename Traits>
+size_t BasicConnectionPool<Connection, Traits>::totalConnections() const {
+   return total_count.load();
+}
+
+template <typename Connection, typename Traits>
+PoolStats BasicConnectionPool<Connection, Traits>::stats() const {
+   PoolStats snap;
+   snap.total_connections  = totalConnections();
+   snap.active_connections = activeConnections();
+   snap.max_connections    = max_connections;
+   snap.waiters            = waiters.load(std::memory_order_relaxed);
+   snap.peak_waiters       = peak_waiters.load(std::memory_order_relaxed);
+   snap.creations          = creations.load(std::memory_order_relaxed);
+   snap.creation_failures  = creation_failures.load(std::memory_order_relaxed);
+   snap.timeouts           = timeouts.load(std::memory_order_relaxed);
+   snap.exhaustion_events  = exhaustion_events.load(std::memory_order_relaxed);
+   snap.broken_evictions   = broken_evictions.load(std::memory_order_relaxed);
+   snap.acquire_wait       = acquire_wait.snapshot();
+   snap.hold_time          = hold_time.snapshot();
+   snap.acquisitions       = snap.acquire_wait.count;
+   return snap;
+}
+
+/* <-------------------------------- Maintenance -------------------------------->*/
+
+template <typename Connection, typename Traits>
+bool BasicConnectionPool<Connection, Traits>::expired(const PooledConnection&              pooled,
+                                                      std::chrono::steady_clock::time_point now) const {
+   return (max_lifetime.count() > 0 && now - pooled.created_at >= max_lifetime) ||
+          (max_uses > 0 && pooled.use_count >= max_uses);
+}
+
+template <typename Connection, typename Traits>
+void BasicConnectionPool<Connection, Traits>::retire(size_t index) {
+   {
+      std::lock_guard<std::mutex> lock(maint_mutex);
+      retired.push_back(index);
+   }
+   maint_cv.notify_one();
+}
+
+template <typename Connection, typename Traits>
+void BasicConnectionPool<Connection, Traits>::closeSlot(size_t index) {
+   connections[index].statements.reset(); // its statements die with the session
+   connections[index].conn.reset();       // sends Terminate and closes the socket
+   total_count.fetch_sub(1);
+   releaseSlot(index);
+}
+
+template <typename Connection, typename Traits>
+void BasicConnectionPool<Connection, Traits>::maintenanceLoop() {
+   std::unique_lock<std::mutex> lock(maint_mutex);
+   while (!stopping) {
+      maint_cv.wait_for(lock, maintenance_interval, [this] { return stopping || !retired.empty(); });
+      if (stopping) {
+         break;
+      }
+      std::vector<size_t> closing;
+      closing.swap(retired);
+      lock.unlock();
+
+      try {
+         for (size_t index : closing) {
+            closeSlot(index);
+         }
+         reapIdle();
+         refill();
+      } catch (const std::exception& e) {
+         std::cerr << "Connection pool maintenance: " << e.what() << std::endl;
+      }
+      lock.lock();
+   }
+}
+
+// Detaches each shard's free list in one exchange, closes what is idle too long or too old, and
+// pushes the keepers back. Borrowers racing with us just see a briefly empty shard and steal elsewhere.
+template <typename Connection, typename Traits>
+void BasicConnectionPool<Connection, Traits>::reapIdle() {
+   if (idle_timeout.count() == 0 && max_lifetime.count() == 0) {
+      return;
+   }
+   auto now = std::chrono::steady_clock::now();
+   for (size_t s = 0; s < shard_count; ++s) {
+      Shard&   shard = shards[s];
+      uint64_t head  = shard.free_head.load();
+      while (!shard.free_head.compare_exchange_weak(head, (((head >> 32) + 1) << 32) | kNoIndex)) {
+      }
+
+      std::vector<size_t> keep;
+      size_t              detached = 0;
+      // next is read before closeSlot(): a closed slot can be regrown, lent and pushed onto another
+      // shard's free list while we're still walking, which rewrites its next_free link
+      for (uint32_t index = static_cast<uint32_t>(head), next; index != kNoIndex; index = next) {
+         next = next_free[index].load(std::memory_order_relaxed);
+         ++detached;
+         const auto& pooled = connections[index];
+         bool        idle   = idle_timeout.count() > 0 && now - pooled.last_used >= idle_timeout &&
+                     total_count.load() > min_connections;
+         if (idle || expired(pooled, now)) {
+            closeSlot(index);
+         } else {
+            keep.push_back(index);
+         }
+      }
+      shard.idle.fetch_sub(static_cast<int64_t>(detached), std::memory_order_relaxed);
+      for (auto it = keep.rbegin(); it != keep.rend(); ++it) { // preserve the original stack order
+         publishIdle(*it, s);
+      }
+   }
+}
+
+// Tops the pool back up to min_connections, one connect at a time and never under pool_mutex.
+template <typename Connection, typename Traits>
+void BasicConnectionPool<Connection, Traits>::refill() {
+   while (reserved_count.load() < min_connections) {
+      size_t slot;
+      {
+         std::lock_guard<std::mutex> lock(pool_mutex);
+         if (reserved_count.load() >= min_connections || !reserveSlot(slot)) {
+            return;
+         }
+      }
+      publishIdle(createConnection(slot), slot % shard_count);
+   }
+}
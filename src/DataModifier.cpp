@@ -1,38 +1,78 @@
 #include "DataModifier.hpp"
+#include "UnitOfWork.hpp"
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <stdexcept>
 
-int DataModifier::insert(const std::string& table, const std::vector<std::string>& columns,
-                         const std::vector<std::string>& values) {
-   if (columns.size() != values.size()) {
-      throw std::invalid_argument("Columns and values must have the same size");
+std::string DataModifier::buildInsertSql(pqxx::connection& conn, const std::string& table,
+                                         const std::vector<std::string>& columns, size_t rows, bool explicit_ids) {
+   std::string query = "INSERT INTO " + conn.quote_name(table) + " (";
+   if (explicit_ids) {
+      query += "id, ";
    }
-   auto conn_handle = pool->getConnection();
-   try {
-      pqxx::work  txn(*conn_handle);
-      std::string query = "INSERT INTO " + txn.quote_name(table) + " (";
+   for (size_t i = 0; i < columns.size(); ++i) {
+      if (i > 0)
+         query += ", ";
+      query += conn.quote_name(columns[i]);
+   }
+   // OVERRIDING SYSTEM VALUE lets the reserved ids into GENERATED ALWAYS identity columns too
+   query += explicit_ids ? ") OVERRIDING SYSTEM VALUE VALUES " : ") VALUES ";
 
-      for (size_t i = 0; i < columns.size(); ++i) {
+   const size_t per_row = columns.size() + (explicit_ids ? 1 : 0);
+   size_t       param   = 1;
+   for (size_t r = 0; r < rows; ++r) {
+      query += r > 0 ? ", (" : "(";
+      for (size_t i = 0; i < per_row; ++i) {
          if (i > 0)
             query += ", ";
-         query += txn.quote_name(columns[i]);
+         query += "$" + std::to_string(param++);
       }
-      query += ") VALUES (";
+      query += ")";
+   }
+   if (!explicit_ids) {
+      query += " RETURNING id";
+   }
+   return query;
+}
 
-      for (size_t i = 0; i < values.size(); ++i) {
-         if (i > 0)
-            query += ", ";
-         query += "$" + std::to_string(i + 1);
-      }
-      query += ") RETURNING id";
+const std::string& DataModifier::insertSql(pqxx::connection& conn, const std::string& table,
+                                           const std::vector<std::string>& columns, size_t rows, bool explicit_ids) {
+   std::string key = table;
+   for (const auto& column : columns) {
+      key += '\x1f' + column;
+   }
+   key += '\x1e' + std::to_string(rows) + (explicit_ids ? "+id" : "");
+
+   std::lock_guard<std::mutex> lock(sql_mutex);
+   auto                        it = sql_texts.find(key);
+   if (it != sql_texts.end()) {
+      return it->second;
+   }
+   return sql_texts.emplace(std::move(key), buildInsertSql(conn, table, columns, rows, explicit_ids)).first->second;
+}
+
+int DataModifier::insert(const std::string& table, const std::vector<std::string>& columns,
+                         const std::vector<std::string>& values) {
+   if (columns.size() != values.size()) {
+      throw std::invalid_argument("Columns and values must have the same size");
+   }
+   OperationMetrics::Timer timer(metrics.get(), OperationMetrics::Op::Insert);
+   auto                    conn_handle = pool->getConnection();
+   try {
+      // prepared once per connection and table/column shape, re-planned never
+      const std::string& statement =
+          conn_handle.statements().prepare(insertSql(*conn_handle, table, columns, 1));
 
       // convert vector to params
       pqxx::params params;
       for (const auto& value : values) {
          params.append(value);
       }
-      pqxx::result result = txn.exec_params(query, params);
+      pqxx::work   txn(*conn_handle);
+      pqxx::result result = txn.exec_prepared(statement, params);
       txn.commit();
+      notifyChanged(table, ChangeKind::Data);
       return result.empty() ? -1 : result[0][0].as<int>();
 
    } catch (const std::exception& e) {
@@ -41,20 +81,178 @@ int DataModifier::insert(const std::string& table, const std::vector<std::string
    }
 }
 
+std::vector<int> DataModifier::insertMany(const std::string& table, const std::vector<std::string>& columns,
+                                          const std::vector<Row>& rows) {
+   if (columns.empty()) {
+      throw std::invalid_argument("insertMany needs at least one column");
+   }
+   if (std::find(columns.begin(), columns.end(), "id") != columns.end()) {
+      throw std::invalid_argument("insertMany assigns the id column itself; leave it out of the column list");
+   }
+   for (size_t r = 0; r < rows.size(); ++r) {
+      if (rows[r].size() != columns.size()) {
+         throw std::invalid_argument("Row " + std::to_string(r + 1) + " has " + std::to_string(rows[r].size()) +
+                                     " values for " + std::to_string(columns.size()) + " columns");
+      }
+   }
+   std::vector<int> ids;
+   if (rows.empty()) {
+      return ids;
+   }
+   ids.reserve(rows.size());
+
+   OperationMetrics::Timer timer(metrics.get(), OperationMetrics::Op::InsertMany);
+   // one extra bind parameter per row carries the reserved id
+   const size_t per_chunk =
+       std::max<size_t>(1, std::min(kMaxRowsPerStatement, kMaxBindParams / (columns.size() + 1)));
+   auto conn_handle = pool->getConnection();
+   try {
+      // Every full chunk shares one prepared statement. The short tail chunk runs unprepared so that
+      // one-off batch sizes don't churn the connection's statement cache.
+      std::string full_chunk;
+      if (rows.size() >= per_chunk) {
+         full_chunk = conn_handle.statements().prepare(insertSql(*conn_handle, table, columns, per_chunk, true));
+      }
+
+      pqxx::work txn(*conn_handle);
+      // RETURNING doesn't promise VALUES order, so the ids are drawn from the column's sequence up front and
+      // written explicitly: row i gets ids[i]. Sorting keeps them ascending in input order, as the default would.
+      pqxx::result reserved = txn.exec_params("SELECT nextval(pg_get_serial_sequence($1, 'id')) "
+                                              "FROM generate_series(1, $2)",
+                                              txn.quote_name(table), static_cast<long long>(rows.size()));
+      for (auto const& row : reserved) {
+         if (row[0].is_null()) {
+            throw std::invalid_argument("insertMany needs a serial or identity id column on '" + table + "'");
+         }
+         ids.push_back(row[0].as<int>());
+      }
+      std::sort(ids.begin(), ids.end());
+
+      for (size_t begin = 0; begin < rows.size(); begin += per_chunk) {
+         size_t       count = std::min(per_chunk, rows.size() - begin);
+         pqxx::params params;
+         params.reserve(count * (columns.size() + 1));
+         for (size_t r = begin; r < begin + count; ++r) {
+            params.append(ids[r]);
+            for (const auto& value : rows[r]) {
+               params.append(value);
+            }
+         }
+
+         // the tail's text is built fresh: caching every odd size would pin hundreds of KB per shape
+         if (count == per_chunk) {
+            txn.exec_prepared(full_chunk, params);
+         } else {
+            txn.exec_params(buildInsertSql(*conn_handle, table, columns, count, true), params);
+         }
+      }
+      txn.commit();
+      notifyChanged(table, ChangeKind::Data);
+      return ids;
+
+   } catch (const std::exception& e) {
+      std::cerr << "Error in batch insert: " << e.what() << std::endl;
+      throw;
+   }
+}
+
 size_t DataModifier::update(const std::string& table, const std::string& set_column, const std::string& set_value,
                             const std::string& where_column, const std::string& where_value) {
-   auto conn_handle = pool->getConnection();
+   OperationMetrics::Timer timer(metrics.get(), OperationMetrics::Op::Update);
+   auto                    conn_handle = pool->getConnection();
    try {
-      pqxx::work  txn(*conn_handle);
-      std::string query = "UPDATE " + txn.esc(table) + " SET " + txn.quote_name(set_column) + " = " +
-                          txn.quote(set_value) + " WHERE " + txn.quote_name(where_column) + " = " +
-                          txn.quote(where_value);
-      pqxx::result result = txn.exec(query);
+      pqxx::work txn(*conn_handle);
+      size_t     affected = update(txn, table, set_column, set_value, where_column, where_value);
       txn.commit();
-      return result.affected_rows();
+      notifyChanged(table, ChangeKind::Data);
+      return affected;
 
    } catch (const std::exception& e) {
       std::cerr << "Error updating data: " << e.what() << std::endl;
       throw;
    }
 }
+
+size_t DataModifier::update(pqxx::transaction_base& txn, const std::string& table, const std::string& set_column,
+                            const std::string& set_value, const std::string& where_column,
+                            const std::string& where_value) {
+   std::string query = "UPDATE " + txn.esc(table) + " SET " + txn.quote_name(set_column) + " = " +
+                       txn.quote(set_value) + " WHERE " + txn.quote_name(where_column) + " = " + txn.quote(where_value);
+   return txn.exec(query).affected_rows();
+}
+
+int DataModifier::insert(pqxx::transaction_base& txn, const std::string& table,
+                         const std::vector<std::string>& columns, const Row& values) {
+   if (columns.size() != values.size()) {
+      throw std::invalid_argument("Columns and values must have the same size");
+   }
+   // Unnamed statement: preparing a named one is not safe while the transaction is open
+   pqxx::params params;
+   for (const auto& value : values) {
+      params.append(value);
+   }
+   pqxx::result result = txn.exec_params(insertSql(txn.conn(), table, columns, 1), params);
+   return result.empty() ? -1 : result[0][0].as<int>();
+}
+
+void DataModifier::transaction(const std::function<void(UnitOfWork& work)>& body) {
+   OperationMetrics::Timer timer(metrics.get(), OperationMetrics::Op::Transaction);
+   auto                    conn_handle = pool->getConnection();
+   try {
+      pqxx::work txn(*conn_handle);
+      UnitOfWork work(*this, txn);
+      body(work);
+      txn.commit();
+      for (const auto& table : work.touchedTables()) {
+         notifyChanged(table, ChangeKind::Data);
+      }
+   } catch (const std::exception& e) {
+      std::cerr << "Transaction rolled back: " << e.what() << std::endl;
+      throw;
+   }
+}
+
+BulkInsertResult DataModifier::bulkInsert(const std::string& table, const std::vector<std::string>& columns,
+                                          const RowSource& next_row) {
+   if (columns.empty()) {
+      throw std::invalid_argument("Bulk insert needs at least one column");
+   }
+   OperationMetrics::Timer timer(metrics.get(), OperationMetrics::Op::BulkInsert);
+   auto                    start       = std::chrono::steady_clock::now();
+   auto                    conn_handle = pool->getConnection();
+   try {
+      pqxx::work  txn(*conn_handle);
+      std::string column_list;
+      for (size_t i = 0; i < columns.size(); ++i) {
+         if (i > 0)
+            column_list += ", ";
+         column_list += txn.quote_name(columns[i]);
+      }
+
+      BulkInsertResult result;
+      auto             stream = pqxx::stream_to::raw_table(txn, txn.quote_name(table), column_list);
+      Row              row;
+      while (next_row(row)) {
+         if (row.size() != columns.size()) {
+            throw std::invalid_argument("Row " + std::to_string(result.rows + 1) + " has " +
+                                        std::to_string(row.size()) + " values for " + std::to_string(columns.size()) +
+                                        " columns");
+         }
+         stream.write_row(row);
+         ++result.rows;
+      }
+      stream.complete();
+      txn.commit();
+      notifyChanged(table, ChangeKind::Data);
+
+      result.elapsed =
+          std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+      std::cout << "Bulk inserted " << result.rows << " rows into '" << table << "' in " << result.elapsed.count()
+                << " ms (" << static_cast<long long>(result.rowsPerSecond()) << " rows/s)" << std::endl;
+      return result;
+
+   } catch (const std::exception& e) {
+      std::cerr << "Error in bulk insert: " << e.what() << std::endl;
+      throw;
+   }
+}
@@ -8,15 +8,45 @@ DatabaseManager::DatabaseManager(const std::string& password,
                                  const std::string& dbname,
                                  const std::string& user,
                                  size_t             min_connections,
-                                 size_t             max_connections) {
-   std::string conn_string = "host=" + host + " port=" + std::to_string(m_port) + " dbname=" + dbname +
-                             " user=" + user + " password=" + password;
+                                 size_t             max_connections)
+    : DatabaseManager(password, host, m_port, dbname, user, PoolOptions{min_connections, max_connections}) {}
 
-   pool = std::make_shared<ConnectionPool>(conn_string, min_connections, max_connections);
+DatabaseManager::DatabaseManager(const std::string& password,
+                                 const std::string& host,
+                                 int                m_port,
+                                 const std::string& dbname,
+                                 const std::string& user,
+                                 const PoolOptions& pool_options) {
+   connection_string = "host=" + host + " port=" + std::to_string(m_port) + " dbname=" + dbname + " user=" + user +
+                       " password=" + password;
+
+   pool    = std::make_shared<ConnectionPool>(connection_string, pool_options);
+   metrics = std::make_shared<OperationMetrics>();
+
+   table_ops = std::make_unique<TableCreator>(pool, metrics);
+   query_ops = std::make_unique<QueryExecutor>(pool, metrics);
+   data_ops  = std::make_unique<DataModifier>(pool, metrics);
 
-   table_ops = std::make_unique<TableCreator>(pool);
-   query_ops = std::make_unique<QueryExecutor>(pool);
-   data_ops  = std::make_unique<DataModifier>(pool);
+   schema_cache = std::make_unique<SchemaCache>(pool);
+   table_ops->addChangeListener([cache = schema_cache.get()](const std::string&, DBOperation::ChangeKind kind) {
+      if (kind == DBOperation::ChangeKind::Schema) {
+         cache->invalidate();
+      }
+   });
+
+   // Registered up front so the operations never see their listener list change; they do nothing
+   // until enableResultCache()
+   auto invalidateResults = [this](const std::string& table, DBOperation::ChangeKind) {
+      if (auto cache = std::atomic_load(&result_cache)) {
+         cache->invalidateTable(table);
+      }
+   };
+   table_ops->addChangeListener(invalidateResults);
+   data_ops->addChangeListener(invalidateResults);
+
+   // One worker per connection the pool can hand out; more would only queue inside getConnection()
+   executor = std::make_unique<TaskExecutor>(pool_options.max_connections,
+                                             pool_options.max_connections * kAsyncQueuePerWorker);
 
    testConnection();
 }
@@ -38,6 +68,66 @@ size_t DatabaseManager::getActiveConnections() const {
 size_t DatabaseManager::getTotalConnections() const {
    return pool->totalConnections();
 }
+
+PoolStats DatabaseManager::getPoolStats() const {
+   return pool->stats();
+}
+
+const OperationMetrics& DatabaseManager::operationMetrics() const {
+   return *metrics;
+}
+std::future<pqxx::result> DatabaseManager::selectAsync(std::string query) {
+   return executor->submit([this, query = std::move(query)] { return query_ops->select(query); });
+}
+
+std::future<int> DatabaseManager::insertAsync(std::string table, std::vector<std::string> columns,
+                                              std::vector<std::string> values) {
+   return executor->submit([this, table = std::move(table), columns = std::move(columns), values = std::move(values)] {
+      return data_ops->insert(table, columns, values);
+   });
+}
+
+std::future<size_t> DatabaseManager::updateAsync(std::string table, std::string set_column, std::string set_value,
+                                                 std::string where_column, std::string where_value) {
+   return executor->submit([this,
+                            table        = std::move(table),
+                            set_column   = std::move(set_column),
+                            set_value    = std::move(set_value),
+                            where_column = std::move(where_column),
+                            where_value  = std::move(where_value)] {
+      return data_ops->update(table, set_column, set_value, where_column, where_value);
+   });
+}
+
+void DatabaseManager::enableResultCache(const ResultCacheOptions& options) {
+   // Only ordinary tables have their writes reported by name; views and the rest make entries drop on any write
+   auto is_plain_table = [schema = schema_cache.get()](const std::string& table) {
+      try {
+         auto info = schema->table(table);
+         return info && info->kind == 'r';
+      } catch (const std::exception&) {
+         return false; // catalog unreachable: treat as unknown
+      }
+   };
+   auto cache = std::make_shared<QueryResultCache>(options, is_plain_table);
+   if (!options.listen_channel.empty()) {
+      cache->listen(connection_string, options.listen_channel);
+   }
+   std::atomic_store(&result_cache, cache);
+   query_ops->setResultCache(cache);
+}
+
+std::shared_ptr<const QueryResultCache> DatabaseManager::resultCache() const {
+   return std::atomic_load(&result_cache);
+}
+
+void DatabaseManager::transaction(const std::function<void(UnitOfWork& work)>& body) {
+   data_ops->transaction(body);
+}
+
+SchemaCache& DatabaseManager::schema() {
+   return *schema_cache;
+}
 TableCreator& DatabaseManager::tables() {
    return *table_ops;
 }
@@ -49,7 +139,17 @@ DataModifier& DatabaseManager::data() {
 }
 
 void DatabaseManager::printPoolStats() {
+   PoolStats stats = pool->stats();
    std::cout << "Pool stats -Active: ";
-   std::cout << pool->activeConnections() << " / Total: ";
-   std::cout << pool->totalConnections() << std::endl;
+   std::cout << stats.active_connections << " / Total: ";
+   std::cout << stats.total_connections << std::endl;
+   std::cout << "  acquisitions: " << stats.acquisitions << "  created: " << stats.creations
+             << "  connect failures: " << stats.creation_failures << "  timeouts: " << stats.timeouts
+             << "  evicted: " << stats.broken_evictions << std::endl;
+   std::cout << "  exhausted: " << stats.exhaustion_events << "  waiters: " << stats.waiters
+             << " (peak " << stats.peak_waiters << ")" << std::endl;
+   std::cout << "  acquire wait us p50/p99/max: " << stats.acquire_wait.percentileUs(0.50) << "/"
+             << stats.acquire_wait.percentileUs(0.99) << "/" << stats.acquire_wait.max_us << std::endl;
+   std::cout << "  hold time us p50/p99/max: " << stats.hold_time.percentileUs(0.50) << "/"
+             << stats.hold_time.percentileUs(0.99) << "/" << stats.hold_time.max_us << std::endl;
 }
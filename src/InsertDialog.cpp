@@ -69,17 +69,13 @@ void InsertDialog::setupUI() {
 
 void InsertDialog::refreshTables() {
    try {
-      std::string query =
-          "SELECT table_name FROM information_schema.tables "
-          "WHERE table_schema = 'public' ORDER BY table_name";
-
-      pqxx::result result = m_dbManager->query().select(query);
+      std::vector<std::string> tables = m_dbManager->schema().tables();
 
       m_tableCombo->clear();
       m_tableCombo->addItem("-- Select Table --");
 
-      for (auto const& row : result) {
-         m_tableCombo->addItem(QString::fromStdString(row[0].as<std::string>()));
+      for (const auto& table : tables) {
+         m_tableCombo->addItem(QString::fromStdString(table));
       }
    } catch (const std::exception& e) {
       QMessageBox::warning(this, "Error", QString("Failed to fetch tables: %1").arg(e.what()));
@@ -100,26 +96,20 @@ void InsertDialog::onTableChanged(const QString& tableName) {
 
 void InsertDialog::fetchTableColumns(const std::string& tableName) {
    try {
-      // Get column information
-      std::string query =
-          "SELECT column_name, data_type, is_nullable, column_default "
-          "FROM information_schema.columns "
-          "WHERE table_schema = 'public' AND table_name = '" +
-          tableName +
-          "' "
-          "ORDER BY ordinal_position";
-
-      pqxx::result result = m_dbManager->query().select(query);
+      // Column information comes from the schema cache, so switching tables costs no round trip
+      std::shared_ptr<const TableInfo> table = m_dbManager->schema().table(tableName);
+      if (!table) {
+         throw std::runtime_error("table '" + tableName + "' not found");
+      }
 
       m_currentColumns.clear();
       m_columnTypes.clear();
       QStringList headers;
 
-      for (auto const& row : result) {
-         std::string colName    = row[0].as<std::string>();
-         std::string dataType   = row[1].as<std::string>();
-         std::string isNullable = row[2].as<std::string>();
-         std::string defaultVal = row[3].is_null() ? "" : row[3].as<std::string>();
+      for (const auto& column : table->columns) {
+         const std::string& colName    = column.name;
+         const std::string& dataType   = column.type;
+         const std::string& defaultVal = column.default_value;
 
          // Skip auto-generated columns
          if (!defaultVal.empty()) {
@@ -140,7 +130,7 @@ void InsertDialog::fetchTableColumns(const std::string& tableName) {
 
          QString header = QString::fromStdString(colName);
          header += "\n(" + QString::fromStdString(dataType) + ")";
-         if (isNullable == "NO" && defaultVal.empty()) {
+         if (!column.nullable && defaultVal.empty()) {
             header += " NOT NULL";
          }
          headers << header;
@@ -180,6 +170,41 @@ void InsertDialog::onRemoveRow() {
    }
 }
 
+bool InsertDialog::collectRow(int row, std::vector<std::optional<std::string>>& values) const {
+   values.clear();
+   bool rowHasData = false;
+
+   // Collect values for this row
+   for (int col = 0; col < m_dataTable->columnCount(); ++col) {
+      QTableWidgetItem* item  = m_dataTable->item(row, col);
+      QString           value = item ? item->text() : "";
+
+      if (!value.isEmpty()) {
+         rowHasData = true;
+      }
+
+      // Handle different data types
+      if (value.isEmpty() || value.toUpper() == "NULL") {
+         values.push_back(std::nullopt);
+      } else if (m_columnTypes[col].find("int") != std::string::npos ||
+                 m_columnTypes[col].find("numeric") != std::string::npos ||
+                 m_columnTypes[col].find("decimal") != std::string::npos ||
+                 m_columnTypes[col].find("float") != std::string::npos ||
+                 m_columnTypes[col].find("double") != std::string::npos ||
+                 m_columnTypes[col].find("real") != std::string::npos) {
+         // Numeric types - no quotes
+         values.push_back(value.toStdString());
+      } else if (m_columnTypes[col].find("bool") != std::string::npos) {
+         // Boolean type
+         values.push_back(value.toLower().toStdString());
+      } else {
+         // String/text types - add quotes
+         values.push_back(value.toStdString());
+      }
+   }
+   return rowHasData;
+}
+
 void InsertDialog::onInsertData() {
    QString tableName = m_tableCombo->currentText();
    if (tableName == "-- Select Table --" || tableName.isEmpty()) {
@@ -192,77 +217,100 @@ void InsertDialog::onInsertData() {
       return;
    }
 
-   try {
-      int                      successCount = 0;
-      std::vector<std::string> failedRows;
-
-      // Process each row
-      for (int row = 0; row < m_dataTable->rowCount(); ++row) {
-         std::vector<std::string> values;
-         bool                     rowHasData = false;
-
-         // Collect values for this row
-         for (int col = 0; col < m_dataTable->columnCount(); ++col) {
-            QTableWidgetItem* item  = m_dataTable->item(row, col);
-            QString           value = item ? item->text() : "";
-
-            if (!value.isEmpty()) {
-               rowHasData = true;
-            }
-
-            // Handle different data types
-            if (value.isEmpty() || value.toUpper() == "NULL") {
-               values.push_back("NULL");
-            } else if (m_columnTypes[col].find("int") != std::string::npos ||
-                       m_columnTypes[col].find("numeric") != std::string::npos ||
-                       m_columnTypes[col].find("decimal") != std::string::npos ||
-                       m_columnTypes[col].find("float") != std::string::npos ||
-                       m_columnTypes[col].find("double") != std::string::npos ||
-                       m_columnTypes[col].find("real") != std::string::npos) {
-               // Numeric types - no quotes
-               values.push_back(value.toStdString());
-            } else if (m_columnTypes[col].find("bool") != std::string::npos) {
-               // Boolean type
-               values.push_back(value.toLower().toStdString());
-            } else {
-               // String/text types - add quotes
-               values.push_back(value.toStdString());
-            }
-         }
-
-         // Skip empty rows
-         if (!rowHasData) {
-            continue;
-         }
-
-         // Use DataModifier's insert method
-         try {
-            int result = m_dbManager->data().insert(tableName.toStdString(), m_currentColumns, values);
+   std::vector<int>  dataRows; // grid rows that have something to insert
+   DataModifier::Row values;
+   for (int row = 0; row < m_dataTable->rowCount(); ++row) {
+      if (collectRow(row, values)) {
+         dataRows.push_back(row);
+      }
+   }
+   if (dataRows.empty()) {
+      QMessageBox::critical(this, "Error", "No rows were inserted");
+      return;
+   }
 
-            if (result > 0) {
-               successCount++;
-            }
-         } catch (const std::exception& e) {
-            failedRows.push_back("Row " + std::to_string(row + 1) + ": " + e.what());
-         }
+   // Several rows: one COPY stream and one commit instead of a round trip and fsync per row
+   if (dataRows.size() > 1) {
+      try {
+         size_t next = 0;
+         auto   result =
+             m_dbManager->data().bulkInsert(tableName.toStdString(), m_currentColumns, [&](DataModifier::Row& row) {
+                if (next == dataRows.size()) {
+                   return false;
+                }
+                collectRow(dataRows[next++], row);
+                return true;
+             });
+         QMessageBox::information(this,
+                                  "Success",
+                                  QString("%1 row(s) inserted successfully in %2 ms (%3 rows/s)")
+                                      .arg(result.rows)
+                                      .arg(result.elapsed.count())
+                                      .arg(static_cast<qlonglong>(result.rowsPerSecond())));
+         emit dataInserted();
+         accept();
+      } catch (const std::exception& e) {
+         // COPY is all-or-nothing; retry row by row so only the bad rows are left out
+         insertRowsIndividually(tableName.toStdString(), dataRows, QString::fromUtf8(e.what()));
       }
+      return;
+   }
 
-      // Show results
-      if (successCount > 0 && failedRows.empty()) {
-         QMessageBox::information(this, "Success", QString("%1 row(s) inserted successfully").arg(successCount));
+   try {
+      collectRow(dataRows.front(), values);
+      // insertMany binds std::nullopt as NULL; insert() only takes strings
+      std::vector<int> ids = m_dbManager->data().insertMany(tableName.toStdString(), m_currentColumns, {values});
+      if (ids.size() == 1) {
+         QMessageBox::information(this, "Success", "1 row(s) inserted successfully");
          emit dataInserted();
          accept();
-      } else if (successCount > 0) {
-         QString msg = QString("%1 row(s) inserted successfully.\n\nFailed rows:\n").arg(successCount);
-         for (const auto& error : failedRows) {
-            msg += QString::fromStdString(error) + "\n";
-         }
-         QMessageBox::warning(this, "Partial Success", msg);
       } else {
          QMessageBox::critical(this, "Error", "No rows were inserted");
       }
-
    } catch (const std::exception& e) {
       QMessageBox::critical(this, "Insert Error", QString("Failed to insert data: %1").arg(e.what()));
    }
 }
+
+void InsertDialog::insertRowsIndividually(const std::string& table, const std::vector<int>& dataRows,
+                                          const QString& copyError) {
+   std::vector<std::string> failedRows;
+   size_t                   successCount = 0;
+   try {
+      // One transaction and one commit; each row gets a SAVEPOINT so a bad row cannot sink the others
+      m_dbManager->transaction([&](UnitOfWork& work) {
+         DataModifier::Row params;
+         for (int row : dataRows) {
+            collectRow(row, params);
+
+            std::string error;
+            if (work.savepoint([&](UnitOfWork& step) { step.insert(table, m_currentColumns, params); }, &error)) {
+               successCount++;
+            } else {
+               failedRows.push_back("Row " + std::to_string(row + 1) + ": " + error);
+            }
+         }
+      });
+   } catch (const std::exception& e) {
+      QMessageBox::critical(this, "Insert Error", QString("No rows were inserted: %1").arg(e.what()));
+      return;
+   }
+
+   if (successCount > 0 && failedRows.empty()) {
+      QMessageBox::information(this, "Success", QString("%1 row(s) inserted successfully").arg(successCount));
+      emit dataInserted();
+      accept();
+   } else if (successCount > 0) {
+      QString msg = QString("%1 row(s) inserted successfully.\n\nFailed rows:\n").arg(successCount);
+      for (const auto& error : failedRows) {
+         msg += QString::fromStdString(error) + "\n";
+      }
+      QMessageBox::warning(this, "Partial Success", msg);
+   } else {
+      QString msg = QString("No rows were inserted (bulk insert: %1).\n\nFailed rows:\n").arg(copyError);
+      for (const auto& error : failedRows) {
+         msg += QString::fromStdString(error) + "\n";
+      }
+      QMessageBox::critical(this, "Error", msg);
+   }
+}
@@ -0,0 +1,77 @@
+#include "LatencyHistogram.hpp"
+#include <algorithm>
+#include <limits>
+
+namespace {
+size_t bucketFor(uint64_t micros) {
+   size_t bucket = 0;
+   while (micros > 0 && bucket + 1 < LatencyHistogram::kBuckets) { // bucket = bit width of micros
+      micros >>= 1;
+      ++bucket;
+   }
+   return bucket;
+}
+
+size_t stripeForThisThread(size_t stripes) {
+   static std::atomic<size_t> next{0};
+   thread_local size_t        stripe = next.fetch_add(1) % stripes;
+   return stripe;
+}
+} // namespace
+
+void LatencyHistogram::record(std::chrono::steady_clock::duration elapsed) {
+   auto     us     = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+   uint64_t micros = us > 0 ? static_cast<uint64_t>(us) : 0;
+
+   // the count is the sum of the buckets, and a sub-microsecond sample (most pool borrows) moves nothing
+   // else, so the common case is a single atomic add
+   Stripe& stripe = stripes[stripeForThisThread(kStripes)];
+   stripe.buckets[bucketFor(micros)].fetch_add(1, std::memory_order_relaxed);
+   if (micros == 0) {
+      return;
+   }
+   stripe.sum_us.fetch_add(micros, std::memory_order_relaxed);
+   uint64_t max = stripe.max_us.load(std::memory_order_relaxed);
+   while (micros > max && !stripe.max_us.compare_exchange_weak(max, micros, std::memory_order_relaxed)) {
+   }
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const {
+   Snapshot snap;
+   for (const auto& stripe : stripes) {
+      for (size_t i = 0; i < kBuckets; ++i) {
+         uint64_t samples = stripe.buckets[i].load(std::memory_order_relaxed);
+         snap.buckets[i] += samples;
+         snap.count += samples;
+      }
+      snap.sum_us += stripe.sum_us.load(std::memory_order_relaxed);
+      snap.max_us = std::max(snap.max_us, stripe.max_us.load(std::memory_order_relaxed));
+   }
+   return snap;
+}
+
+uint64_t LatencyHistogram::Snapshot::upperBoundUs(size_t bucket) {
+   if (bucket + 1 >= kBuckets) {
+      return std::numeric_limits<uint64_t>::max();
+   }
+   return uint64_t{1} << bucket;
+}
+
+double LatencyHistogram::Snapshot::meanUs() const {
+   return count == 0 ? 0.0 : static_cast<double>(sum_us) / static_cast<double>(count);
+}
+
+uint64_t LatencyHistogram::Snapshot::percentileUs(double p) const {
+   if (count == 0) {
+      return 0;
+   }
+   auto     rank = static_cast<uint64_t>(std::clamp(p, 0.0, 1.0) * static_cast<double>(count - 1)) + 1;
+   uint64_t seen = 0;
+   for (size_t i = 0; i < kBuckets; ++i) {
+      seen += buckets[i];
+      if (seen >= rank) {
+         return std::min(upperBoundUs(i), max_us);
+      }
+   }
+   return max_us;
+}
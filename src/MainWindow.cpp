@@ -1,7 +1,10 @@
 #include "MainWindow.hpp"
 #include "InsertDialog.hpp"
+#include "MetricsServer.hpp"
+#include "ResultTableModel.hpp"
 #include <QAction>
 #include <QDate>
+#include <QElapsedTimer>
 #include <QGridLayout>
 #include <QGroupBox>
 #include <QHBoxLayout>
@@ -35,9 +38,23 @@ MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent), m_isConnected(fal
    m_poolSizeSpinBox->setValue(5);
 
    updateConnectionStatus(false);
+
+   // Optional Prometheus scrape endpoint, e.g. PGPOOL_METRICS_PORT=9187
+   int metricsPort = qEnvironmentVariableIntValue("PGPOOL_METRICS_PORT");
+   if (metricsPort > 0 && metricsPort <= 65535) {
+      m_metricsServer = new MetricsServer(this);
+      if (m_metricsServer->listen(static_cast<quint16>(metricsPort))) {
+         m_logOutput->append(QString("Serving metrics on http://127.0.0.1:%1/metrics").arg(metricsPort));
+      } else {
+         m_logOutput->append(QString("Could not listen for metrics on port %1").arg(metricsPort));
+      }
+   }
 }
 
-MainWindow::~MainWindow() = default;
+MainWindow::~MainWindow() {
+   // An open browse cursor holds a pooled connection; give it back before the pool goes away
+   m_resultsModel->clear();
+}
 
 void MainWindow::setupUI() {
    auto* centralWidget = new QWidget(this);
@@ -166,6 +183,9 @@ void MainWindow::setupUI() {
    m_insertBtn = new QPushButton("Insert Data", this);
    m_insertBtn->setEnabled(false);
    tableLayout->addWidget(m_insertBtn);
+   m_browseCheck = new QCheckBox("Browse (page in rows while scrolling)", this);
+   m_browseCheck->setChecked(true);
+   tableLayout->addWidget(m_browseCheck);
    tableLayout->addStretch();
    queryLayout->addLayout(tableLayout);
 
@@ -228,9 +248,11 @@ void MainWindow::setupUI() {
     }
    )");
    auto* resultsLayout = new QVBoxLayout(resultsGroup);
-   m_resultsTable      = new QTableWidget(this);
-   m_resultsTable->setStyleSheet(R"(
-    QTableWidget {
+   m_resultsModel      = new ResultTableModel(this);
+   m_resultsView       = new QTableView(this);
+   m_resultsView->setModel(m_resultsModel);
+   m_resultsView->setStyleSheet(R"(
+    QTableView {
         background-color: #1a1a1a;
         gridline-color: #3d3d3d;
         color: #e0e0e0;
@@ -244,15 +266,22 @@ void MainWindow::setupUI() {
         padding: 5px;
         font-weight: bold;
     }
-    QTableWidget::item {
+    QTableView::item {
         padding: 5px;
     }
-    QTableWidget::item:hover {
+    QTableView::item:hover {
         background-color: #2d2d2d;
     }
    )");
-   m_resultsTable->horizontalHeader()->setStretchLastSection(true);
-   resultsLayout->addWidget(m_resultsTable);
+   m_resultsView->horizontalHeader()->setStretchLastSection(true);
+   // Fixed row heights: the view never measures rows it is not showing
+   m_resultsView->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+   m_resultsView->verticalHeader()->setDefaultSectionSize(m_resultsView->fontMetrics().height() + 12);
+   m_resultsView->setWordWrap(false);
+   resultsLayout->addWidget(m_resultsView);
+   connect(m_resultsModel, &ResultTableModel::fetchFailed, this, [this](const QString& message) {
+      m_logOutput->append(QString("Error fetching more rows: %1").arg(message));
+   });
 
    resultsLogSplitter->addWidget(resultsGroup);
 
@@ -312,7 +341,12 @@ void MainWindow::setupUI() {
    // Connect signals
    connect(m_connectBtn, &QPushButton::clicked, this, &MainWindow::onConnectDatabase);
    connect(m_executeBtn, &QPushButton::clicked, this, &MainWindow::onExecuteQuery);
-   connect(m_refreshBtn, &QPushButton::clicked, this, &MainWindow::onRefreshTables);
+   connect(m_refreshBtn, &QPushButton::clicked, this, [this]() {
+      if (m_dbManager) {
+         m_dbManager->schema().invalidate();
+      }
+      onRefreshTables();
+   });
    connect(m_insertBtn, &QPushButton::clicked, this, &MainWindow::onInsertData);
    connect(m_testPoolBtn, &QPushButton::clicked, this, &MainWindow::onTestConnectionPool);
    connect(m_tableCombo, &QComboBox::currentTextChanged, this, &MainWindow::onTableSelectionChanged);
@@ -352,11 +386,14 @@ void MainWindow::onConnectDatabase() {
    try {
       if (m_isConnected) {
          // Disconnect
+         if (m_metricsServer) {
+            m_metricsServer->setDatabase(nullptr);
+         }
+         m_resultsModel->clear(); // releases a browse cursor's connection before the pool is destroyed
          m_dbManager.reset();
          updateConnectionStatus(false);
          m_logOutput->append("Disconnected from database.");
          m_tableCombo->clear();
-         m_resultsTable->clear();
 
          m_queryEdit->setPlaceholderText("Query Requires Database Connection...");
          QPalette palette = m_queryEdit->palette();
@@ -372,18 +409,24 @@ void MainWindow::onConnectDatabase() {
       std::string user     = m_userEdit->text().toStdString();
       std::string password = m_passwordEdit->text().toStdString();
 
-      // Initialize database manager with connection parameters
-      m_dbManager = std::make_unique<DatabaseManager>(password,                      // password
-                                                      host,                          // host
-                                                      port,                          // port
-                                                      dbname,                        // dbname
-                                                      user,                          // user
-                                                      m_poolSizeSpinBox->value(),    // min_connections
-                                                      m_poolSizeSpinBox->value() * 2 // max_connections
-      );
-
-      // Test the connection
-      m_dbManager->testConnection();
+      // Open the pool concurrently and hand control back as soon as the first connection is up;
+      // the rest of the pool fills in the background while the UI loads tables
+      PoolOptions poolOptions;
+      poolOptions.min_connections = m_poolSizeSpinBox->value();
+      poolOptions.max_connections = m_poolSizeSpinBox->value() * 2;
+      poolOptions.warmup_async    = true;
+
+      // Initialize database manager with connection parameters (its constructor already runs testConnection)
+      m_dbManager = std::make_unique<DatabaseManager>(password, // password
+                                                      host,     // host
+                                                      port,     // port
+                                                      dbname,   // dbname
+                                                      user,     // user
+                                                      poolOptions);
+
+      if (m_metricsServer) {
+         m_metricsServer->setDatabase(m_dbManager.get());
+      }
 
       updateConnectionStatus(true);
       m_logOutput->append(
@@ -411,31 +454,19 @@ void MainWindow::onExecuteQuery() {
       auto start = std::chrono::high_resolution_clock::now();
 
       // Check if it's a SELECT query
-      if (query.trimmed().startsWith("SELECT", Qt::CaseInsensitive)) {
+      if (query.trimmed().startsWith("SELECT", Qt::CaseInsensitive) && m_browseCheck->isChecked()) {
+         browseResults(query.toStdString());
+      } else if (query.trimmed().startsWith("SELECT", Qt::CaseInsensitive)) {
          // Use QueryExecutor's select method
          pqxx::result result = m_dbManager->query().select(query.toStdString());
 
          auto end      = std::chrono::high_resolution_clock::now();
          auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
 
-         // Process results - using indices for column names
-         std::vector<std::string> columns;
-         for (size_t i = 0; i < result.columns(); ++i) {
-            columns.push_back(result.column_name(i));
-         }
-
-         std::vector<std::vector<std::string>> rows;
-         for (auto const& row : result) {
-            std::vector<std::string> rowData;
-            for (auto const& field : row) {
-               rowData.push_back(field.is_null() ? "NULL" : field.as<std::string>());
-            }
-            rows.push_back(rowData);
-         }
-
-         displayResults(rows, columns);
+         const auto rowCount = result.size();
+         displayResults(std::move(result));
          m_logOutput->append(
-             QString("Query executed successfully in %1 ms. Rows returned: %2").arg(duration).arg(result.size()));
+             QString("Query executed successfully in %1 ms. Rows returned: %2").arg(duration).arg(rowCount));
       } else if (query.trimmed().startsWith("INSERT", Qt::CaseInsensitive)) {
          // For INSERT queries, parse and use DataModifier
          // This is a simplified approach - you might want more robust parsing
@@ -468,21 +499,17 @@ void MainWindow::onRefreshTables() {
       return;
 
    try {
-      // Use QueryExecutor to get table list from information_schema
-      std::string query =
-          "SELECT table_name FROM information_schema.tables "
-          "WHERE table_schema = 'public' ORDER BY table_name";
-
-      pqxx::result result = m_dbManager->query().select(query);
+      // Served from the schema cache; only the Refresh button forces a catalog read
+      std::vector<std::string> tables = m_dbManager->schema().tables();
 
       m_tableCombo->clear();
       m_tableCombo->addItem("-- Select Table --");
 
-      for (auto const& row : result) {
-         m_tableCombo->addItem(QString::fromStdString(row[0].as<std::string>()));
+      for (const auto& table : tables) {
+         m_tableCombo->addItem(QString::fromStdString(table));
       }
 
-      m_logOutput->append(QString("Found %1 tables").arg(result.size()));
+      m_logOutput->append(QString("Found %1 tables").arg(tables.size()));
 
    } catch (const std::exception& e) {
       m_logOutput->append(QString("Error refreshing tables: %1").arg(e.what()));
@@ -494,7 +521,9 @@ void MainWindow::onTableSelectionChanged() {
       return;
 
    QString tableName = m_tableCombo->currentText();
-   QString query     = QString("SELECT * FROM %1 LIMIT 100").arg(tableName);
+   // Browse mode pages the table in on demand, so only a materialized result needs a cap
+   QString query = m_browseCheck->isChecked() ? QString("SELECT * FROM %1").arg(tableName)
+                                              : QString("SELECT * FROM %1 LIMIT 100").arg(tableName);
    m_queryEdit->setPlainText(query);
 }
 
@@ -511,6 +540,19 @@ void MainWindow::onTestConnectionPool() {
       // Test the connection
       m_dbManager->testConnection();
 
+      PoolStats stats = m_dbManager->getPoolStats();
+      m_logOutput->append(QString("Pool: %1 active / %2 total, %3 acquisitions, %4 exhausted, peak waiters %5")
+                              .arg(stats.active_connections)
+                              .arg(stats.total_connections)
+                              .arg(stats.acquisitions)
+                              .arg(stats.exhaustion_events)
+                              .arg(stats.peak_waiters));
+      m_logOutput->append(QString("Acquire wait p50/p99: %1/%2 us, hold time p50/p99: %3/%4 us")
+                              .arg(stats.acquire_wait.percentileUs(0.50))
+                              .arg(stats.acquire_wait.percentileUs(0.99))
+                              .arg(stats.hold_time.percentileUs(0.50))
+                              .arg(stats.hold_time.percentileUs(0.99)));
+
       m_logOutput->append("Connection pool test completed successfully!");
 
    } catch (const std::exception& e) {
@@ -572,28 +614,40 @@ void MainWindow::updateConnectionStatus(bool connected) {
    m_poolSizeSpinBox->setEnabled(!connected);
 }
 
-void MainWindow::displayResults(const std::vector<std::vector<std::string>>& results,
-                                const std::vector<std::string>&              columns) {
-   m_resultsTable->clear();
-   m_resultsTable->setColumnCount(columns.size());
-   m_resultsTable->setRowCount(results.size());
+void MainWindow::displayResults(pqxx::result result) {
+   QElapsedTimer timer;
+   timer.start();
+   const auto rows = result.size();
 
-   // Set headers
-   QStringList headers;
-   for (const auto& col : columns) {
-      headers << QString::fromStdString(col);
-   }
-   m_resultsTable->setHorizontalHeaderLabels(headers);
+   m_resultsModel->setResult(std::move(result));
+   fitColumns();
+   m_resultsView->viewport()->repaint(); // synchronous, so the elapsed time below covers the first paint
 
-   // Populate data
-   for (size_t row = 0; row < results.size(); ++row) {
-      for (size_t col = 0; col < results[row].size(); ++col) {
-         auto* item = new QTableWidgetItem(QString::fromStdString(results[row][col]));
-         m_resultsTable->setItem(row, col, item);
-      }
-   }
+   m_logOutput->append(QString("Displayed %1 rows, time to first paint: %2 ms").arg(rows).arg(timer.elapsed()));
+}
+
+void MainWindow::browseResults(const std::string& query) {
+   QElapsedTimer timer;
+   timer.start();
+
+   // The cursor keeps one pooled connection until the result is exhausted or replaced
+   m_resultsModel->clear();
+   m_resultsModel->setCursor(m_dbManager->query().openCursor(query));
+   fitColumns();
+   m_resultsView->viewport()->repaint();
 
-   m_resultsTable->resizeColumnsToContents();
+   m_logOutput->append(QString("Browsing %1 rows so far%2, time to first paint: %3 ms")
+                           .arg(m_resultsModel->rowCount())
+                           .arg(m_resultsModel->browsing() ? " (more load while scrolling)" : "")
+                           .arg(timer.elapsed()));
+}
+
+void MainWindow::fitColumns() {
+   const std::vector<int> widths = m_resultsModel->estimateColumnWidths(m_resultsView->fontMetrics());
+   for (size_t col = 0; col < widths.size(); ++col) {
+      m_resultsView->setColumnWidth(static_cast<int>(col), widths[col]);
+   }
+   m_resultsView->scrollToTop();
 }
 
 void MainWindow::onInsertData() {
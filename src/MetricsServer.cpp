@@ -0,0 +1,163 @@
+#include "MetricsServer.hpp"
+#include "DatabaseManager.hpp"
+#include <QHostAddress>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <memory>
+#include <sstream>
+
+namespace {
+constexpr int kMaxRequestBytes = 8192;
+
+double toSeconds(uint64_t micros) {
+   return static_cast<double>(micros) / 1e6;
+}
+
+void writeHistogram(std::ostringstream&               out,
+                    const std::string&                name,
+                    const std::string&                labels, // e.g. op="select", empty for none
+                    const LatencyHistogram::Snapshot& snap) {
+   std::string prefix = labels.empty() ? "" : labels + ",";
+   uint64_t    cumulative = 0;
+   for (size_t i = 0; i + 1 < LatencyHistogram::kBuckets; ++i) {
+      cumulative += snap.buckets[i];
+      out << name << "_bucket{" << prefix << "le=\"" << toSeconds(LatencyHistogram::Snapshot::upperBoundUs(i))
+          << "\"} " << cumulative << "\n";
+   }
+   cumulative += snap.buckets[LatencyHistogram::kBuckets - 1];
+   out << name << "_bucket{" << prefix << "le=\"+Inf\"} " << cumulative << "\n";
+   std::string braces = labels.empty() ? "" : "{" + labels + "}";
+   out << name << "_sum" << braces << " " << toSeconds(snap.sum_us) << "\n";
+   out << name << "_count" << braces << " " << cumulative << "\n";
+}
+
+void writeScalar(std::ostringstream& out, const char* name, const char* type, const char* help, uint64_t value) {
+   out << "# HELP " << name << " " << help << "\n";
+   out << "# TYPE " << name << " " << type << "\n";
+   out << name << " " << value << "\n";
+}
+} // namespace
+
+MetricsServer::MetricsServer(QObject* parent) : QObject(parent), m_server(new QTcpServer(this)) {
+   connect(m_server, &QTcpServer::newConnection, this, &MetricsServer::onNewConnection);
+}
+
+bool MetricsServer::listen(quint16 port) {
+   return m_server->listen(QHostAddress::LocalHost, port);
+}
+
+quint16 MetricsServer::port() const {
+   return m_server->serverPort();
+}
+
+void MetricsServer::setDatabase(DatabaseManager* dbManager) {
+   m_dbManager = dbManager;
+}
+
+void MetricsServer::onNewConnection() {
+   while (QTcpSocket* socket = m_server->nextPendingConnection()) {
+      auto buffer = std::make_shared<QByteArray>();
+      connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+      connect(socket, &QTcpSocket::readyRead, this, [this, socket, buffer]() {
+         buffer->append(socket->readAll());
+         if (buffer->size() > kMaxRequestBytes) {
+            socket->abort();
+            return;
+         }
+         if (!buffer->contains("\r\n\r\n")) {
+            return; // headers not complete yet
+         }
+         respond(socket, buffer->left(buffer->indexOf("\r\n")));
+      });
+   }
+}
+
+void MetricsServer::respond(QTcpSocket* socket, const QByteArray& requestLine) {
+   QList<QByteArray> parts = requestLine.split(' ');
+   QByteArray        status;
+   QByteArray        contentType = "text/plain; charset=utf-8";
+   QByteArray        body;
+
+   if (parts.size() < 2 || parts[0] != "GET") {
+      status = "405 Method Not Allowed";
+      body   = "only GET is supported\n";
+   } else if (parts[1] != "/metrics") {
+      status = "404 Not Found";
+      body   = "try /metrics\n";
+   } else {
+      status      = "200 OK";
+      contentType = "text/plain; version=0.0.4; charset=utf-8";
+      body        = render(m_dbManager);
+   }
+
+   QByteArray response = "HTTP/1.1 " + status + "\r\nContent-Type: " + contentType +
+                         "\r\nContent-Length: " + QByteArray::number(body.size()) + "\r\nConnection: close\r\n\r\n" +
+                         body;
+   socket->write(response);
+   socket->disconnectFromHost();
+}
+
+QByteArray MetricsServer::render(const DatabaseManager* dbManager) {
+   std::ostringstream out;
+   out << "# HELP pgpool_up Whether the application currently holds a connection pool.\n";
+   out << "# TYPE pgpool_up gauge\n";
+   out << "pgpool_up " << (dbManager ? 1 : 0) << "\n";
+   if (!dbManager) {
+      return QByteArray::fromStdString(out.str());
+   }
+
+   PoolStats stats = dbManager->getPoolStats();
+   out << "# HELP pgpool_connections Open pool connections by state.\n";
+   out << "# TYPE pgpool_connections gauge\n";
+   out << "pgpool_connections{state=\"active\"} " << stats.active_connections << "\n";
+   out << "pgpool_connections{state=\"idle\"} " << stats.total_connections - stats.active_connections << "\n";
+   writeScalar(out, "pgpool_max_connections", "gauge", "Configured pool ceiling.", stats.max_connections);
+   writeScalar(out, "pgpool_waiters", "gauge", "Borrowers currently queued for a connection.", stats.waiters);
+   writeScalar(out, "pgpool_peak_waiters", "gauge", "Most borrowers ever queued at once.", stats.peak_waiters);
+   writeScalar(out, "pgpool_acquisitions_total", "counter", "Connection handles granted.", stats.acquisitions);
+   writeScalar(out, "pgpool_connections_created_total", "counter", "Connections opened.", stats.creations);
+   writeScalar(
+       out, "pgpool_connect_failures_total", "counter", "Failed connection attempts.", stats.creation_failures);
+   writeScalar(out, "pgpool_acquire_timeouts_total", "counter", "Acquire deadlines missed.", stats.timeouts);
+   writeScalar(
+       out, "pgpool_exhausted_total", "counter", "Borrows that had to queue for a connection.", stats.exhaustion_events);
+   writeScalar(out, "pgpool_evictions_total", "counter", "Broken connections evicted.", stats.broken_evictions);
+
+   out << "# HELP pgpool_acquire_wait_seconds Time from getConnection to handle granted.\n";
+   out << "# TYPE pgpool_acquire_wait_seconds histogram\n";
+   writeHistogram(out, "pgpool_acquire_wait_seconds", "", stats.acquire_wait);
+   out << "# HELP pgpool_hold_seconds Time a connection handle was held.\n";
+   out << "# TYPE pgpool_hold_seconds histogram\n";
+   writeHistogram(out, "pgpool_hold_seconds", "", stats.hold_time);
+
+   const OperationMetrics& ops = dbManager->operationMetrics();
+   std::ostringstream      errors;
+   out << "# HELP pgpool_query_duration_seconds Latency of database operations, including the connection borrow.\n";
+   out << "# TYPE pgpool_query_duration_seconds histogram\n";
+   errors << "# HELP pgpool_query_errors_total Database operations that ended in an exception.\n";
+   errors << "# TYPE pgpool_query_errors_total counter\n";
+   for (size_t i = 0; i < OperationMetrics::kOpCount; ++i) {
+      auto                       op    = static_cast<OperationMetrics::Op>(i);
+      OperationMetrics::Snapshot snap  = ops.snapshot(op);
+      std::string                label = std::string("op=\"") + OperationMetrics::name(op) + "\"";
+      writeHistogram(out, "pgpool_query_duration_seconds", label, snap.latency);
+      errors << "pgpool_query_errors_total{" << label << "} " << snap.errors << "\n";
+   }
+   out << errors.str();
+
+   if (auto cache = dbManager->resultCache()) {
+      QueryResultCache::Stats cached = cache->stats();
+      writeScalar(out, "pgpool_result_cache_hits_total", "counter", "Cached selects served from memory.", cached.hits);
+      writeScalar(out, "pgpool_result_cache_misses_total", "counter", "Cached selects that ran.", cached.misses);
+      writeScalar(
+          out, "pgpool_result_cache_evictions_total", "counter", "Evicted by the byte limit.", cached.evictions);
+      writeScalar(out,
+                  "pgpool_result_cache_invalidations_total",
+                  "counter",
+                  "Entries dropped by writes or NOTIFY.",
+                  cached.invalidations);
+      writeScalar(out, "pgpool_result_cache_entries", "gauge", "Results currently cached.", cached.entries);
+      writeScalar(out, "pgpool_result_cache_bytes", "gauge", "Estimated size of cached results.", cached.bytes);
+   }
+   return QByteArray::fromStdString(out.str());
+}
@@ -0,0 +1,50 @@
+#include "OperationMetrics.hpp"
+
+const char* OperationMetrics::name(Op op) {
+   switch (op) {
+      case Op::Select:
+         return "select";
+      case Op::SelectPrepared:
+         return "select_prepared";
+      case Op::SelectMany:
+         return "select_many";
+      case Op::SelectCached:
+         return "select_cached";
+      case Op::ReadSnapshot:
+         return "read_snapshot";
+      case Op::Stream:
+         return "stream";
+      case Op::SelectColumnar:
+         return "select_columnar";
+      case Op::Insert:
+         return "insert";
+      case Op::Update:
+         return "update";
+      case Op::CreateTable:
+         return "create_table";
+      case Op::DropTable:
+         return "drop_table";
+      case Op::BulkInsert:
+         return "bulk_insert";
+      case Op::InsertMany:
+         return "insert_many";
+      case Op::Transaction:
+         return "transaction";
+      case Op::Count:
+         break;
+   }
+   return "unknown";
+}
+
+void OperationMetrics::record(Op op, std::chrono::steady_clock::duration elapsed, bool failed) {
+   Entry& entry = entries[static_cast<size_t>(op)];
+   entry.latency.record(elapsed);
+   if (failed) {
+      entry.errors.fetch_add(1, std::memory_order_relaxed);
+   }
+}
+
+OperationMetrics::Snapshot OperationMetrics::snapshot(Op op) const {
+   const Entry& entry = entries[static_cast<size_t>(op)];
+   return {entry.latency.snapshot(), entry.errors.load(std::memory_order_relaxed)};
+}
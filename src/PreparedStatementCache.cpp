@@ -0,0 +1,137 @@
+#include "PreparedStatementCache.hpp"
+#include <algorithm>
+#include <cctype>
+
+PreparedStatementCache::PreparedStatementCache(pqxx::connection& connection, size_t capacity)
+    : conn(connection), capacity(std::max<size_t>(capacity, 1)) {}
+
+namespace {
+bool isIdentChar(char c) {
+   return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '$' || (c & 0x80) != 0;
+}
+
+// Length of the lexeme starting at sql[i] that must be copied verbatim: a quoted string or identifier,
+// an E'...' string with backslash escapes, a $tag$...$tag$ body, or a -- or (nested) /* */ comment.
+// Returns 0 when sql[i] starts none of these. An unterminated lexeme runs to the end of the text.
+size_t verbatimLength(const std::string& sql, size_t i) {
+   const size_t n     = sql.size();
+   char         c     = sql[i];
+   bool         ident = i > 0 && isIdentChar(sql[i - 1]);
+   if (c == '\'' || c == '"' || ((c == 'E' || c == 'e') && !ident && i + 1 < n && sql[i + 1] == '\'')) {
+      bool   escapes = c == 'E' || c == 'e';
+      size_t j       = escapes ? i + 2 : i + 1;
+      char   quote   = escapes ? '\'' : c;
+      for (; j < n; ++j) {
+         if (escapes && sql[j] == '\\') {
+            ++j;
+         } else if (sql[j] == quote) {
+            if (j + 1 < n && sql[j + 1] == quote) {
+               ++j; // doubled quote
+            } else {
+               return j + 1 - i;
+            }
+         }
+      }
+      return n - i;
+   }
+   if (c == '$' && !ident) {
+      size_t j = i + 1;
+      if (j < n && !std::isdigit(static_cast<unsigned char>(sql[j]))) { // $1 is a parameter, not a tag
+         while (j < n && sql[j] != '$' && isIdentChar(sql[j])) {
+            ++j;
+         }
+      }
+      if (j < n && sql[j] == '$') {
+         std::string tag   = sql.substr(i, j + 1 - i);
+         size_t      close = sql.find(tag, j + 1);
+         return close == std::string::npos ? n - i : close + tag.size() - i;
+      }
+      return 0;
+   }
+   if (c == '-' && i + 1 < n && sql[i + 1] == '-') {
+      size_t newline = sql.find('\n', i);
+      return newline == std::string::npos ? n - i : newline + 1 - i; // the newline must survive
+   }
+   if (c == '/' && i + 1 < n && sql[i + 1] == '*') {
+      int    depth = 1;
+      size_t j     = i + 2;
+      while (j < n && depth > 0) {
+         if (sql.compare(j, 2, "/*") == 0) {
+            ++depth;
+            j += 2;
+         } else if (sql.compare(j, 2, "*/") == 0) {
+            --depth;
+            j += 2;
+         } else {
+            ++j;
+         }
+      }
+      return j - i;
+   }
+   return 0;
+}
+} // namespace
+
+std::string PreparedStatementCache::normalize(const std::string& sql) {
+   std::string out;
+   out.reserve(sql.size());
+   bool pending_space = false;
+   for (size_t i = 0; i < sql.size();) {
+      char c = sql[i];
+      if (std::isspace(static_cast<unsigned char>(c))) {
+         pending_space = !out.empty();
+         ++i;
+         continue;
+      }
+      if (pending_space) {
+         out += ' ';
+         pending_space = false;
+      }
+      size_t length = std::max<size_t>(verbatimLength(sql, i), 1);
+      out.append(sql, i, length);
+      i += length;
+   }
+   return out;
+}
+
+const std::string& PreparedStatementCache::prepare(const std::string& sql) {
+   std::string key = normalize(sql);
+   auto        it  = index.find(key);
+   if (it != index.end()) {
+      ++hit_count;
+      lru.splice(lru.begin(), lru, it->second);
+      return it->second->second;
+   }
+
+   ++miss_count;
+   if (lru.size() >= capacity) {
+      Entry& victim = lru.back();
+      try {
+         conn.unprepare(victim.second);
+      } catch (const pqxx::broken_connection&) {
+         throw;
+      } catch (const std::exception&) {
+         // statement already gone server-side; forgetting it is all that's left to do
+      }
+      index.erase(victim.first);
+      lru.pop_back();
+   }
+
+   std::string name = "pgpool_stmt_" + std::to_string(next_id++);
+   conn.prepare(name, sql); // the caller's text; the normalized form is only the lookup key
+   lru.emplace_front(std::move(key), std::move(name));
+   index.emplace(lru.front().first, lru.begin());
+   return lru.front().second;
+}
+
+size_t PreparedStatementCache::size() const {
+   return lru.size();
+}
+
+uint64_t PreparedStatementCache::hits() const {
+   return hit_count;
+}
+
+uint64_t PreparedStatementCache::misses() const {
+   return miss_count;
+}
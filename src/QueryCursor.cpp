@@ -0,0 +1,69 @@
+#include "QueryCursor.hpp"
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+
+namespace {
+std::string nextCursorName() {
+   static std::atomic<uint64_t> next{0};
+   return "pgpool_cursor_" + std::to_string(next.fetch_add(1));
+}
+
+// DECLARE takes a single statement, so a trailing ';' (common when pasted from an editor) must go
+std::string stripTrailingSemicolons(const std::string& query) {
+   size_t end = query.find_last_not_of(" \t\r\n;");
+   return end == std::string::npos ? std::string() : query.substr(0, end + 1);
+}
+} // namespace
+
+QueryCursor::QueryCursor(ConnectionPool::ConnectionHandle connection, const std::string& query, size_t fetch_size)
+    : handle(std::move(connection)), name(nextCursorName()), page_size(std::max<size_t>(fetch_size, 1)) {
+   txn = std::make_unique<pqxx::work>(**handle);
+   txn->exec("DECLARE " + txn->quote_name(name) + " NO SCROLL CURSOR FOR " + stripTrailingSemicolons(query));
+}
+
+QueryCursor::~QueryCursor() {
+   try {
+      close();
+   } catch (const std::exception& e) {
+      std::cerr << "Error closing cursor: " << e.what() << std::endl;
+   }
+}
+
+pqxx::result QueryCursor::fetch() {
+   return fetch(page_size);
+}
+
+pqxx::result QueryCursor::fetch(size_t rows) {
+   if (done || !txn) {
+      return pqxx::result();
+   }
+   rows              = std::max<size_t>(rows, 1);
+   pqxx::result page = txn->exec("FETCH FORWARD " + std::to_string(rows) + " FROM " + txn->quote_name(name));
+   fetched += static_cast<size_t>(page.size());
+   if (static_cast<size_t>(page.size()) < rows) { // a short page means the cursor ran dry
+      done = true;
+   }
+   return page;
+}
+
+void QueryCursor::close() {
+   done = true;
+   if (txn) {
+      std::unique_ptr<pqxx::work> finishing = std::move(txn);
+      finishing->commit(); // ending the transaction closes the cursor server-side
+   }
+   handle.reset();
+}
+
+bool QueryCursor::exhausted() const {
+   return done;
+}
+
+size_t QueryCursor::rowsFetched() const {
+   return fetched;
+}
+
+size_t QueryCursor::fetchSize() const {
+   return page_size;
+}
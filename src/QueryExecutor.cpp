@@ -12,11 +12,11 @@
  * */
 
 pqxx::result QueryExecutor::select(const std::string& query) {
-   auto conn_handle = pool->getConnection();
+   OperationMetrics::Timer timer(metrics.get(), OperationMetrics::Op::Select);
+   auto                    conn_handle = pool->getConnection();
    try {
-      pqxx::work   txn(*conn_handle);
-      pqxx::result result = txn.exec(query);
-      txn.commit();
+      pqxx::nontransaction txn(*conn_handle);
+      pqxx::result         result = txn.exec(query);
       std::cout << "Query ruturned " << result.size() << " rows" << std::endl;
       return result;
    } catch (const pqxx::sql_error& e) {
@@ -27,18 +27,189 @@ pqxx::result QueryExecutor::select(const std::string& query) {
 
 pqxx::result QueryExecutor::selectPrepared(const std::string& table, const std::string& condition_column,
                                            const std::string& value) {
-   auto conn_handle = pool->getConnection();
+   OperationMetrics::Timer timer(metrics.get(), OperationMetrics::Op::SelectPrepared);
+   auto                    conn_handle = pool->getConnection();
 
    try {
-      pqxx::work txn(*conn_handle);
-      // Using pqxx's safe parameterization
+      // Same shape -> same server-side statement, so repeat lookups skip parse/plan entirely
       std::string query =
-          "SELECT * FROM " + txn.esc(table) + " WHERE " + txn.quote_name(condition_column) + " = " + txn.quote(value);
-      pqxx::result result = txn.exec(query);
-      txn.commit();
-      return result;
+          "SELECT * FROM " + conn_handle->esc(table) + " WHERE " + conn_handle->quote_name(condition_column) + " = $1";
+      const std::string& statement = conn_handle.statements().prepare(query);
+
+      pqxx::nontransaction txn(*conn_handle);
+      return txn.exec_prepared(statement, value);
    } catch (const std::exception& e) {
       std::cerr << "Error in prepared select: " << e.what() << std::endl;
       throw;
    }
 }
+
+QueryResultCache::ResultPtr QueryExecutor::selectCached(const std::string&                       query,
+                                                        const std::vector<std::string>&          params,
+                                                        std::optional<std::chrono::milliseconds> ttl) {
+   OperationMetrics::Timer timer(metrics.get(), OperationMetrics::Op::SelectCached);
+   auto                    cache = std::atomic_load(&result_cache);
+   std::string             key;
+   uint64_t                epoch = 0;
+   if (cache) {
+      key = QueryResultCache::key(query, params);
+      if (auto cached = cache->get(key)) {
+         return cached;
+      }
+      epoch = cache->writeEpoch(); // before the query runs, so a concurrent write keeps it out
+   }
+
+   QueryResultCache::ResultPtr result;
+   try {
+      auto                 conn_handle = pool->getConnection();
+      pqxx::nontransaction txn(*conn_handle);
+      pqxx::params         bound;
+      for (const auto& param : params) {
+         bound.append(param);
+      }
+      result = std::make_shared<const pqxx::result>(txn.exec_params(query, bound));
+   } catch (const pqxx::sql_error& e) {
+      std::cerr << "SQL Error in cached query: " << e.what() << std::endl;
+      throw;
+   }
+   // The connection is back in the pool: put() may look the tables up in the schema cache, which can
+   // need one of its own
+   if (cache) {
+      cache->put(key, query, result, epoch, ttl);
+   }
+   return result;
+}
+
+void QueryExecutor::setResultCache(std::shared_ptr<QueryResultCache> cache) {
+   std::atomic_store(&result_cache, std::move(cache));
+}
+
+void QueryExecutor::readSnapshot(const std::function<void(SnapshotTransaction& txn)>& body) {
+   OperationMetrics::Timer timer(metrics.get(), OperationMetrics::Op::ReadSnapshot);
+   auto                    conn_handle = pool->getConnection();
+   try {
+      SnapshotTransaction txn(*conn_handle);
+      body(txn);
+      txn.commit();
+   } catch (const std::exception& e) {
+      std::cerr << "Error in snapshot read: " << e.what() << std::endl;
+      throw;
+   }
+}
+
+size_t BatchResult::failures() const {
+   size_t count = 0;
+   for (const auto& outcome : outcomes) {
+      count += outcome.ok() ? 0 : 1;
+   }
+   return count;
+}
+
+BatchResult QueryExecutor::selectMany(const std::vector<std::string>& queries) {
+   OperationMetrics::Timer timer(metrics.get(), OperationMetrics::Op::SelectMany);
+   BatchResult             batch;
+   batch.outcomes.resize(queries.size());
+   if (queries.empty()) {
+      return batch;
+   }
+
+   auto conn_handle = pool->getConnection();
+   try {
+      // No explicit BEGIN/COMMIT, but pqxx::pipeline sends the batch as one multi-statement query, which
+      // the server runs as a single implicit transaction: a failure rolls back everything before it in
+      // that batch and skips everything after it
+      pqxx::nontransaction txn(*conn_handle);
+
+      size_t next = 0;
+      while (next < queries.size()) {
+         pqxx::pipeline pipe(txn);
+         pipe.retain(static_cast<int>(queries.size() - next)); // hold everything back until complete()
+
+         std::vector<pqxx::pipeline::query_id> ids;
+         ids.reserve(queries.size() - next);
+         for (size_t i = next; i < queries.size(); ++i) {
+            ids.push_back(pipe.insert(queries[i]));
+         }
+         pipe.complete();
+         ++batch.round_trips;
+
+         size_t resume_at = queries.size();
+         for (size_t i = 0; i < ids.size(); ++i) {
+            try {
+               batch.outcomes[next + i].result = pipe.retrieve(ids[i]);
+            } catch (const pqxx::sql_error& e) {
+               // Resend what the failed statement's batch skipped, as a new batch
+               batch.outcomes[next + i].error = e.what();
+               resume_at                      = next + i + 1;
+               break;
+            }
+         }
+         next = resume_at;
+      }
+   } catch (const std::exception& e) {
+      std::cerr << "Error in pipelined select: " << e.what() << std::endl;
+      throw;
+   }
+
+   batch.round_trips_saved = queries.size() - batch.round_trips;
+   std::cout << "Pipelined " << queries.size() << " queries in " << batch.round_trips << " round trip(s), saved "
+             << batch.round_trips_saved << " (" << batch.failures() << " failed)" << std::endl;
+   return batch;
+}
+
+std::unique_ptr<QueryCursor> QueryExecutor::openCursor(const std::string& query, size_t fetch_size) {
+   try {
+      return std::make_unique<QueryCursor>(pool->getConnection(), query, fetch_size);
+   } catch (const pqxx::sql_error& e) {
+      std::cerr << "SQL Error opening cursor: " << e.what() << std::endl;
+      throw;
+   }
+}
+
+size_t QueryExecutor::stream(const std::string&                           query,
+                             const std::function<bool(const pqxx::row&)>& on_row,
+                             size_t                                       fetch_size) {
+   OperationMetrics::Timer timer(metrics.get(), OperationMetrics::Op::Stream);
+   auto                    cursor    = openCursor(query, fetch_size);
+   size_t                  delivered = 0;
+
+   try {
+      while (!cursor->exhausted()) {
+         pqxx::result page = cursor->fetch();
+         for (const auto& row : page) {
+            ++delivered;
+            if (!on_row(row)) {
+               cursor->close();
+               return delivered;
+            }
+         }
+      }
+      cursor->close();
+      std::cout << "Query streamed " << delivered << " rows" << std::endl;
+      return delivered;
+   } catch (const pqxx::sql_error& e) {
+      std::cerr << "SQL Error in streamed query: " << e.what() << std::endl;
+      throw;
+   }
+}
+
+ColumnarResult QueryExecutor::selectColumnar(const std::string&     query,
+                                             const ColumnarOptions& options,
+                                             size_t                 fetch_size) {
+   OperationMetrics::Timer timer(metrics.get(), OperationMetrics::Op::SelectColumnar);
+   auto                    cursor = openCursor(query, fetch_size);
+   ColumnarResult          columnar(options);
+
+   try {
+      do {
+         columnar.append(cursor->fetch()); // the first page is appended even when empty: it carries the schema
+      } while (!cursor->exhausted());
+      cursor->close();
+      std::cout << "Query returned " << columnar.rows() << " rows in " << columnar.memoryBytes() << " bytes (columnar)"
+                << std::endl;
+      return columnar;
+   } catch (const std::exception& e) {
+      std::cerr << "Error in columnar select: " << e.what() << std::endl;
+      throw;
+   }
+}
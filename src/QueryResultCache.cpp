@@ -0,0 +1,359 @@
+#include "QueryResultCache.hpp"
+#include "PreparedStatementCache.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <iterator>
+#include <iostream>
+
+namespace {
+constexpr size_t kFieldOverhead = 16; // libpq keeps a length and a pointer per field
+
+struct Token {
+   std::string text;               // lower-cased, even when quoted; schema qualifiers dropped
+   bool        identifier = false; // word or quoted name, possibly schema-qualified
+   bool        qualified  = false; // a schema (or other) qualifier was dropped
+};
+
+bool isWordChar(char c) {
+   return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '$';
+}
+
+// Just enough of a lexer to find relation names: words, quoted names, punctuation. Literals and
+// comments are skipped. Names are folded to lower case even when quoted: callers report tables
+// both ways, and folding too much only costs an extra invalidation.
+std::vector<Token> tokenize(const std::string& sql) {
+   std::vector<Token> tokens;
+   size_t             i = 0;
+   while (i < sql.size()) {
+      char c = sql[i];
+      if (std::isspace(static_cast<unsigned char>(c))) {
+         ++i;
+      } else if (c == '-' && i + 1 < sql.size() && sql[i + 1] == '-') {
+         i = sql.find('\n', i);
+         i = i == std::string::npos ? sql.size() : i + 1;
+      } else if (c == '/' && i + 1 < sql.size() && sql[i + 1] == '*') {
+         i = sql.find("*/", i + 2);
+         i = i == std::string::npos ? sql.size() : i + 2;
+      } else if (c == '\'') {
+         for (++i; i < sql.size(); ++i) {
+            if (sql[i] == '\'' && (i + 1 == sql.size() || sql[i + 1] != '\'')) {
+               break;
+            }
+            i += sql[i] == '\'' ? 1 : 0; // '' is an escaped quote
+         }
+         ++i;
+         tokens.push_back({"'", false});
+      } else if (c == '"' || isWordChar(c)) {
+         // One or more dot-separated parts; only the last one (the relation name) is kept
+         Token token{"", true};
+         for (;;) {
+            token.text.clear();
+            if (i < sql.size() && sql[i] == '"') {
+               for (++i; i < sql.size(); ++i) {
+                  if (sql[i] == '"' && (i + 1 == sql.size() || sql[i + 1] != '"')) {
+                     break;
+                  }
+                  i += sql[i] == '"' ? 1 : 0;
+                  token.text += static_cast<char>(std::tolower(static_cast<unsigned char>(sql[i])));
+               }
+               ++i;
+            } else {
+               for (; i < sql.size() && isWordChar(sql[i]); ++i) {
+                  token.text += static_cast<char>(std::tolower(static_cast<unsigned char>(sql[i])));
+               }
+            }
+            if (i + 1 < sql.size() && sql[i] == '.' && (sql[i + 1] == '"' || isWordChar(sql[i + 1]))) {
+               ++i;
+               token.qualified = true;
+               continue;
+            }
+            break;
+         }
+         token.identifier = !token.text.empty() && !std::isdigit(static_cast<unsigned char>(token.text[0]));
+         tokens.push_back(std::move(token));
+      } else {
+         tokens.push_back({std::string(1, c), false});
+         ++i;
+      }
+   }
+   return tokens;
+}
+
+bool isClauseKeyword(const std::string& word) {
+   static const char* const kKeywords[] = {
+       "where", "join",  "on",     "using",  "left",   "right",     "inner",  "outer",  "full",  "cross",       "natural",
+       "group", "order", "limit",  "offset", "having", "union",     "except", "window", "for",   "tablesample", "fetch",
+       "intersect", "returning"};
+   return std::any_of(std::begin(kKeywords), std::end(kKeywords), [&](const char* k) { return word == k; });
+}
+
+// Words that may sit right before "(" without being a function call: syntax, and the few builtins that
+// only read their arguments. Anything else called could be volatile (now(), random()), have side effects
+// (nextval()) or read relations the query doesn't name.
+bool isHarmlessBeforeParen(const std::string& word) {
+   static const char* const kWords[] = {
+       // syntax
+       "select", "from", "join", "lateral", "where", "and", "or", "not", "in", "exists", "any", "some", "all",
+       "values", "as", "on", "using", "over", "filter", "group", "by", "having", "union", "except", "intersect",
+       "limit", "offset", "distinct", "when", "then", "else", "between", "is", "like", "ilike", "row", "array",
+       "cast", "coalesce", "nullif", "greatest", "least", "returning", "with", "recursive",
+       // aggregates and immutable scalar functions
+       "count", "sum", "avg", "min", "max", "bool_and", "bool_or", "every", "string_agg", "array_agg", "json_agg",
+       "jsonb_agg", "lower", "upper", "length", "char_length", "abs", "round", "trunc", "floor", "ceil", "ceiling",
+       "substring", "substr", "trim", "btrim", "ltrim", "rtrim", "concat", "concat_ws", "replace", "split_part",
+       "position", "extract", "date_part", "date_trunc"};
+   return std::any_of(std::begin(kWords), std::end(kWords), [&](const char* k) { return word == k; });
+}
+} // namespace
+
+QueryResultCache::QueryResultCache(const ResultCacheOptions& options, PlainTableCheck is_plain_table)
+    : max_bytes(options.max_bytes), default_ttl(options.ttl), plain_table(std::move(is_plain_table)) {}
+
+QueryResultCache::~QueryResultCache() {
+   stopping = true;
+   if (listener.joinable()) {
+      listener.join();
+   }
+}
+
+std::string QueryResultCache::key(const std::string& sql, const std::vector<std::string>& params) {
+   std::string key = PreparedStatementCache::normalize(sql);
+   for (const auto& param : params) {
+      key += '\x1e' + std::to_string(param.size()) + ':' + param; // length-prefixed, so values cannot collide
+   }
+   return key;
+}
+
+std::string QueryResultCache::normalizeTable(const std::string& table) {
+   std::vector<Token> tokens = tokenize(table);
+   return tokens.empty() ? std::string() : tokens.front().text;
+}
+
+bool QueryResultCache::referencedTables(const std::string& sql, std::vector<std::string>& tables) {
+   std::vector<Token> tokens   = tokenize(sql);
+   bool               complete = true;
+   auto               word     = [&](size_t j, const char* text) {
+      return j < tokens.size() && tokens[j].identifier && tokens[j].text == text;
+   };
+   auto punct = [&](size_t j, char c) {
+      return j < tokens.size() && !tokens[j].identifier && tokens[j].text.size() == 1 && tokens[j].text[0] == c;
+   };
+
+   for (size_t i = 0; i + 1 < tokens.size(); ++i) {
+      if (!tokens[i].identifier || !punct(i + 1, '(')) {
+         continue;
+      }
+      bool type_modifier = (i > 0 && punct(i - 1, ':')) || (i > 0 && word(i - 1, "as")); // ::numeric(10, 2)
+      if (!type_modifier && (tokens[i].qualified || !isHarmlessBeforeParen(tokens[i].text))) {
+         complete = false; // a function call: result may change, or depend on tables, without a write
+         break;
+      }
+   }
+
+   for (size_t i = 0; i < tokens.size(); ++i) {
+      if (!word(i, "from") && !word(i, "join")) {
+         continue;
+      }
+      size_t j = i + 1;
+      for (;;) {
+         while (word(j, "only") || word(j, "lateral")) {
+            ++j;
+         }
+         if (j >= tokens.size() || !tokens[j].identifier) {
+            break; // a sub-select: its own FROM is picked up by the outer loop
+         }
+         if (punct(j + 1, '(')) {
+            complete = false; // set-returning function, may read anything
+            break;
+         }
+         if (std::find(tables.begin(), tables.end(), tokens[j].text) == tables.end()) {
+            tables.push_back(tokens[j].text);
+         }
+         ++j;
+         if (word(j, "as")) {
+            ++j;
+         }
+         if (j < tokens.size() && tokens[j].identifier && !isClauseKeyword(tokens[j].text)) {
+            ++j; // alias
+         }
+         if (!punct(j, ',')) {
+            break;
+         }
+         ++j;
+      }
+   }
+   return complete;
+}
+
+QueryResultCache::ResultPtr QueryResultCache::get(const std::string& key) {
+   std::lock_guard<std::mutex> lock(cache_mutex);
+   auto                        it = index.find(key);
+   if (it == index.end()) {
+      misses.fetch_add(1, std::memory_order_relaxed);
+      return nullptr;
+   }
+   if (std::chrono::steady_clock::now() >= it->second->expires) {
+      erase(it->second);
+      misses.fetch_add(1, std::memory_order_relaxed);
+      return nullptr;
+   }
+   lru.splice(lru.begin(), lru, it->second);
+   hits.fetch_add(1, std::memory_order_relaxed);
+   return it->second->result;
+}
+
+void QueryResultCache::put(const std::string&                       key,
+                           const std::string&                       sql,
+                           ResultPtr                                result,
+                           uint64_t                                 epoch,
+                           std::optional<std::chrono::milliseconds> ttl) {
+   Entry entry;
+   entry.key       = key;
+   entry.bytes     = estimateBytes(*result) + key.size();
+   entry.expires   = std::chrono::steady_clock::now() + ttl.value_or(default_ttl);
+   entry.any_write = !referencedTables(sql, entry.tables);
+   if (!entry.any_write && plain_table) {
+      // a view or partitioned table changes through writes reported under other names
+      entry.any_write = !std::all_of(entry.tables.begin(), entry.tables.end(), plain_table);
+   }
+   entry.result    = std::move(result);
+   if (entry.bytes > max_bytes) {
+      return; // would evict everything else and still not fit
+   }
+
+   std::lock_guard<std::mutex> lock(cache_mutex);
+   if (write_epoch.load() != epoch) {
+      return;
+   }
+   if (auto it = index.find(key); it != index.end()) {
+      erase(it->second);
+   }
+   while (total_bytes + entry.bytes > max_bytes && !lru.empty()) {
+      erase(std::prev(lru.end()));
+      evictions.fetch_add(1, std::memory_order_relaxed);
+   }
+
+   lru.push_front(std::move(entry));
+   Entry& stored = lru.front();
+   index.emplace(stored.key, lru.begin());
+   total_bytes += stored.bytes;
+   if (stored.any_write) {
+      any_write.insert(stored.key);
+   }
+   for (const auto& table : stored.tables) {
+      by_table[table].insert(stored.key);
+   }
+}
+
+uint64_t QueryResultCache::writeEpoch() const {
+   return write_epoch.load();
+}
+
+void QueryResultCache::invalidateTable(const std::string& table) {
+   const std::string           name = normalizeTable(table);
+   std::lock_guard<std::mutex> lock(cache_mutex);
+   write_epoch.fetch_add(1); // under the lock, so put() cannot slip a stale result in after this
+   if (name.empty()) {
+      invalidations.fetch_add(lru.size(), std::memory_order_relaxed);
+      while (!lru.empty()) {
+         erase(lru.begin());
+      }
+      return;
+   }
+
+   std::vector<std::string> keys(any_write.begin(), any_write.end());
+   if (auto it = by_table.find(name); it != by_table.end()) {
+      keys.insert(keys.end(), it->second.begin(), it->second.end());
+   }
+   for (const auto& key : keys) {
+      if (auto it = index.find(key); it != index.end()) {
+         erase(it->second);
+         invalidations.fetch_add(1, std::memory_order_relaxed);
+      }
+   }
+}
+
+void QueryResultCache::clear() {
+   invalidateTable("");
+}
+
+QueryResultCache::Stats QueryResultCache::stats() const {
+   Stats stats;
+   stats.hits          = hits.load(std::memory_order_relaxed);
+   stats.misses        = misses.load(std::memory_order_relaxed);
+   stats.evictions     = evictions.load(std::memory_order_relaxed);
+   stats.invalidations = invalidations.load(std::memory_order_relaxed);
+   std::lock_guard<std::mutex> lock(cache_mutex);
+   stats.entries = lru.size();
+   stats.bytes   = total_bytes;
+   return stats;
+}
+
+size_t QueryResultCache::estimateBytes(const pqxx::result& result) {
+   size_t bytes = sizeof(pqxx::result);
+   for (int col = 0; col < static_cast<int>(result.columns()); ++col) {
+      bytes += std::strlen(result.column_name(col)) + kFieldOverhead;
+   }
+   for (const auto& row : result) {
+      for (const auto& field : row) {
+         bytes += field.size() + kFieldOverhead;
+      }
+   }
+   return bytes;
+}
+
+void QueryResultCache::erase(EntryList::iterator it) {
+   for (const auto& table : it->tables) {
+      auto keys = by_table.find(table);
+      if (keys != by_table.end()) {
+         keys->second.erase(it->key);
+         if (keys->second.empty()) {
+            by_table.erase(keys);
+         }
+      }
+   }
+   any_write.erase(it->key);
+   total_bytes -= it->bytes;
+   index.erase(it->key);
+   lru.erase(it);
+}
+
+/* <-------------------------------- LISTEN -------------------------------->*/
+
+void QueryResultCache::listen(const std::string& conn_str, const std::string& channel) {
+   if (listener.joinable()) {
+      throw std::logic_error("QueryResultCache is already listening");
+   }
+   listener = std::thread(&QueryResultCache::listenLoop, this, conn_str, channel);
+}
+
+void QueryResultCache::listenLoop(std::string conn_str, std::string channel) {
+   class Receiver : public pqxx::notification_receiver {
+    public:
+      Receiver(pqxx::connection& conn, const std::string& channel, QueryResultCache& owner)
+          : pqxx::notification_receiver(conn, channel), cache(owner) {}
+      void operator()(const std::string& payload, int) override {
+         cache.invalidateTable(payload == "*" ? std::string() : payload);
+      }
+
+    private:
+      QueryResultCache& cache;
+   };
+
+   while (!stopping) {
+      try {
+         pqxx::connection conn(conn_str);
+         Receiver         receiver(conn, channel, *this);
+         clear(); // anything could have changed while we were not listening
+         while (!stopping) {
+            conn.await_notification(0, 200000); // wake up regularly to notice shutdown
+         }
+      } catch (const std::exception& e) {
+         std::cerr << "Result cache listener error: " << e.what() << std::endl;
+         for (int i = 0; i < 10 && !stopping; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+         }
+      }
+   }
+}
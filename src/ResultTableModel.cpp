@@ -0,0 +1,157 @@
+#include "ResultTableModel.hpp"
+#include <QColor>
+#include <QFontMetrics>
+#include <algorithm>
+#include <iterator>
+
+namespace {
+constexpr int kMaxSampledChars = 64;  // long text/json cells would dominate the estimate
+constexpr int kCellPadding     = 24;  // matches the stylesheet's item padding plus the grid line
+constexpr int kMaxColumnWidth  = 400; // wider cells get elided; the user can still drag the header
+} // namespace
+
+ResultTableModel::ResultTableModel(QObject* parent) : QAbstractTableModel(parent) {}
+
+void ResultTableModel::setResult(pqxx::result result) {
+   beginResetModel();
+   releaseCursor();
+   m_pages.clear();
+   m_pageStarts.clear();
+   m_rows = 0;
+   appendPage(std::move(result));
+   endResetModel();
+}
+
+void ResultTableModel::setCursor(std::unique_ptr<QueryCursor> cursor) {
+   pqxx::result first = cursor->fetch();
+   setResult(std::move(first)); // also drops any previous cursor
+   if (!cursor->exhausted()) {
+      m_cursor = std::move(cursor);
+   }
+}
+
+void ResultTableModel::clear() {
+   setResult(pqxx::result());
+}
+
+bool ResultTableModel::browsing() const {
+   return m_cursor != nullptr;
+}
+
+int ResultTableModel::rowCount(const QModelIndex& parent) const {
+   return parent.isValid() ? 0 : m_rows;
+}
+
+int ResultTableModel::columnCount(const QModelIndex& parent) const {
+   return parent.isValid() || m_pages.empty() ? 0 : static_cast<int>(m_pages.front().columns());
+}
+
+QVariant ResultTableModel::data(const QModelIndex& index, int role) const {
+   if (!index.isValid()) {
+      return QVariant();
+   }
+
+   const pqxx::field field = cell(index.row(), index.column());
+   switch (role) {
+      case Qt::DisplayRole:
+         if (field.is_null()) {
+            return QStringLiteral("NULL");
+         }
+         return QString::fromUtf8(field.c_str(), static_cast<qsizetype>(field.size()));
+      case Qt::ForegroundRole:
+         if (field.is_null()) {
+            return QColor(110, 110, 110);
+         }
+         return QVariant();
+      default:
+         return QVariant();
+   }
+}
+
+QVariant ResultTableModel::headerData(int section, Qt::Orientation orientation, int role) const {
+   if (role != Qt::DisplayRole) {
+      return QVariant();
+   }
+   if (orientation == Qt::Horizontal) {
+      return m_pages.empty() ? QVariant() : QString::fromUtf8(m_pages.front().column_name(section));
+   }
+   return section + 1;
+}
+
+bool ResultTableModel::canFetchMore(const QModelIndex& parent) const {
+   return !parent.isValid() && m_cursor && !m_cursor->exhausted();
+}
+
+void ResultTableModel::fetchMore(const QModelIndex& parent) {
+   if (!canFetchMore(parent)) {
+      return;
+   }
+
+   pqxx::result page;
+   try {
+      page = m_cursor->fetch();
+   } catch (const std::exception& e) {
+      releaseCursor();
+      emit fetchFailed(QString::fromUtf8(e.what()));
+      return;
+   }
+
+   if (!page.empty()) {
+      beginInsertRows(QModelIndex(), m_rows, m_rows + static_cast<int>(page.size()) - 1);
+      appendPage(std::move(page));
+      endInsertRows();
+   }
+   if (m_cursor->exhausted()) {
+      releaseCursor(); // hand the connection back as soon as the last row is in
+   }
+}
+
+pqxx::field ResultTableModel::cell(int row, int column) const {
+   // Last page starting at or before `row`
+   auto   it   = std::upper_bound(m_pageStarts.begin(), m_pageStarts.end(), row);
+   size_t page = static_cast<size_t>(std::distance(m_pageStarts.begin(), it)) - 1;
+   return m_pages[page][row - m_pageStarts[page]][column];
+}
+
+void ResultTableModel::appendPage(pqxx::result page) {
+   // Keep the first page even when empty: it carries the column names
+   if (page.empty() && !m_pages.empty()) {
+      return;
+   }
+   m_pageStarts.push_back(m_rows);
+   m_rows += static_cast<int>(page.size());
+   m_pages.push_back(std::move(page));
+}
+
+void ResultTableModel::releaseCursor() {
+   if (!m_cursor) {
+      return;
+   }
+   try {
+      m_cursor->close();
+   } catch (const std::exception&) {
+      // the connection is returned (or marked for rebuild) either way
+   }
+   m_cursor.reset();
+}
+
+std::vector<int> ResultTableModel::estimateColumnWidths(const QFontMetrics& metrics, int sampleRows) const {
+   const int        rows    = rowCount();
+   const int        columns = columnCount();
+   const int        samples = std::min(rows, std::max(sampleRows, 1));
+   std::vector<int> widths(columns, 0);
+
+   for (int col = 0; col < columns; ++col) {
+      int width = metrics.horizontalAdvance(QString::fromUtf8(m_pages.front().column_name(col)));
+      for (int i = 0; i < samples; ++i) {
+         const int         row   = static_cast<int>(static_cast<qint64>(i) * rows / samples);
+         const pqxx::field field = cell(row, col);
+         const size_t      bytes = std::min<size_t>(field.size(), kMaxSampledChars);
+         const QString     text  = field.is_null() ? QStringLiteral("NULL")
+                                                   : QString::fromUtf8(field.c_str(), static_cast<qsizetype>(bytes));
+         width = std::max(width, metrics.horizontalAdvance(text));
+      }
+      widths[col] = std::min(width + kCellPadding, kMaxColumnWidth);
+   }
+   return widths;
+}
@@ -0,0 +1,122 @@
+#include "SchemaCache.hpp"
+#include <iostream>
+
+namespace {
+// Same relations information_schema.tables lists (tables, partitioned tables, views, foreign tables),
+// without its per-row privilege checks
+const char* const kCatalogQuery = R"(
+SELECT c.relname,
+       a.attname,
+       format_type(a.atttypid, a.atttypmod),
+       NOT a.attnotnull,
+       pg_get_expr(d.adbin, d.adrelid),
+       c.relkind
+FROM pg_catalog.pg_class c
+JOIN pg_catalog.pg_namespace n ON n.oid = c.relnamespace
+LEFT JOIN pg_catalog.pg_attribute a ON a.attrelid = c.oid AND a.attnum > 0 AND NOT a.attisdropped
+LEFT JOIN pg_catalog.pg_attrdef d ON d.adrelid = c.oid AND d.adnum = a.attnum
+WHERE n.nspname = $1 AND c.relkind IN ('r', 'p', 'v', 'f')
+ORDER BY c.relname, a.attnum)";
+} // namespace
+
+SchemaCache::SchemaCache(std::shared_ptr<ConnectionPool> connection_pool,
+                         std::chrono::milliseconds       time_to_live,
+                         std::string                     schema)
+    : pool(std::move(connection_pool)), ttl(time_to_live), schema_name(std::move(schema)) {}
+
+std::vector<std::string> SchemaCache::tables() {
+   return current()->table_names;
+}
+
+std::shared_ptr<const TableInfo> SchemaCache::table(const std::string& name) {
+   auto snap = current();
+   auto it   = snap->by_name.find(name);
+   if (it == snap->by_name.end()) {
+      return nullptr;
+   }
+   return std::shared_ptr<const TableInfo>(snap, &it->second); // keeps the whole snapshot alive
+}
+
+void SchemaCache::invalidate() {
+   std::lock_guard<std::mutex> lock(snapshot_mutex);
+   snapshot.reset();
+   ++generation;
+}
+
+void SchemaCache::refresh() {
+   invalidate();
+   current();
+}
+
+uint64_t SchemaCache::loads() const {
+   return load_count.load(std::memory_order_relaxed);
+}
+
+std::shared_ptr<const SchemaCache::Snapshot> SchemaCache::current() {
+   auto fresh = [this] {
+      return snapshot && (ttl.count() == 0 || std::chrono::steady_clock::now() - snapshot->loaded_at < ttl);
+   };
+   {
+      std::lock_guard<std::mutex> lock(snapshot_mutex);
+      if (fresh()) {
+         return snapshot;
+      }
+   }
+
+   std::lock_guard<std::mutex> loading(load_mutex);
+   uint64_t                    started_at;
+   {
+      std::lock_guard<std::mutex> lock(snapshot_mutex);
+      if (fresh()) {
+         return snapshot; // another thread loaded it while we waited
+      }
+      started_at = generation;
+   }
+
+   auto loaded = load();
+   {
+      std::lock_guard<std::mutex> lock(snapshot_mutex);
+      // DDL committed while the catalog was being read may be missing from `loaded`: serve it to this
+      // caller but leave the cache empty so the next lookup reads the catalog again
+      if (generation == started_at) {
+         snapshot = loaded;
+      }
+   }
+   return loaded;
+}
+
+std::shared_ptr<const SchemaCache::Snapshot> SchemaCache::load() {
+   auto conn_handle = pool->getConnection();
+   try {
+      pqxx::nontransaction txn(*conn_handle);
+      pqxx::result         result = txn.exec_params(kCatalogQuery, schema_name);
+
+      auto snap       = std::make_shared<Snapshot>();
+      snap->loaded_at = std::chrono::steady_clock::now();
+      TableInfo* info = nullptr;
+      for (const auto& row : result) {
+         std::string relname = row[0].as<std::string>();
+         if (!info || info->name != relname) {
+            snap->table_names.push_back(relname);
+            info       = &snap->by_name[relname];
+            info->name = relname;
+            info->kind = row[5].as<std::string>().front();
+         }
+         if (row[1].is_null()) {
+            continue; // a table without columns still gets its entry
+         }
+         ColumnInfo column;
+         column.name          = row[1].as<std::string>();
+         column.type          = row[2].as<std::string>();
+         column.nullable      = row[3].as<bool>();
+         column.has_default   = !row[4].is_null();
+         column.default_value = column.has_default ? row[4].as<std::string>() : "";
+         info->columns.push_back(std::move(column));
+      }
+      load_count.fetch_add(1, std::memory_order_relaxed);
+      return snap;
+   } catch (const std::exception& e) {
+      std::cerr << "Error loading schema: " << e.what() << std::endl;
+      throw;
+   }
+}
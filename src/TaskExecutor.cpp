@@ -0,0 +1,70 @@
+#include "TaskExecutor.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+TaskExecutor::TaskExecutor(size_t worker_count, size_t capacity) : queue_capacity(std::max<size_t>(capacity, 1)) {
+   worker_count = std::max<size_t>(worker_count, 1);
+   workers.reserve(worker_count);
+   for (size_t i = 0; i < worker_count; ++i) {
+      workers.emplace_back(&TaskExecutor::workerLoop, this);
+   }
+}
+
+TaskExecutor::~TaskExecutor() {
+   {
+      std::lock_guard<std::mutex> lock(queue_mutex);
+      stopping = true;
+   }
+   not_empty.notify_all();
+   not_full.notify_all();
+   for (auto& worker : workers) {
+      worker.join();
+   }
+}
+
+bool TaskExecutor::enqueue(std::function<void()> task, bool wait) {
+   std::unique_lock<std::mutex> lock(queue_mutex);
+   if (wait) {
+      not_full.wait(lock, [this] { return stopping || tasks.size() < queue_capacity; });
+   }
+   if (stopping) {
+      throw std::runtime_error("TaskExecutor is shutting down");
+   }
+   if (tasks.size() >= queue_capacity) {
+      return false;
+   }
+   tasks.push_back(std::move(task));
+   lock.unlock();
+   not_empty.notify_one();
+   return true;
+}
+
+void TaskExecutor::workerLoop() {
+   for (;;) {
+      std::function<void()> task;
+      {
+         std::unique_lock<std::mutex> lock(queue_mutex);
+         not_empty.wait(lock, [this] { return stopping || !tasks.empty(); });
+         if (tasks.empty()) {
+            return; // stopping and drained
+         }
+         task = std::move(tasks.front());
+         tasks.pop_front();
+      }
+      not_full.notify_one();
+      task(); // packaged_task stores any exception in the future
+   }
+}
+
+size_t TaskExecutor::workerCount() const {
+   return workers.size();
+}
+
+size_t TaskExecutor::queued() const {
+   std::lock_guard<std::mutex> lock(queue_mutex);
+   return tasks.size();
+}
+
+size_t TaskExecutor::capacity() const {
+   return queue_capacity;
+}
@@ -0,0 +1,56 @@
+#include "UnitOfWork.hpp"
+
+UnitOfWork::UnitOfWork(DataModifier& modifier, pqxx::dbtransaction& transaction)
+    : data(modifier), active(&transaction) {}
+
+int UnitOfWork::insert(const std::string& table, const std::vector<std::string>& columns,
+                       const DataModifier::Row& values) {
+   touched.insert(table);
+   return data.insert(*active, table, columns, values);
+}
+
+size_t UnitOfWork::update(const std::string& table, const std::string& set_column, const std::string& set_value,
+                          const std::string& where_column, const std::string& where_value) {
+   touched.insert(table);
+   return data.update(*active, table, set_column, set_value, where_column, where_value);
+}
+
+pqxx::result UnitOfWork::exec(const std::string& sql) {
+   touched.insert("");
+   return active->exec(sql);
+}
+
+bool UnitOfWork::savepoint(const std::function<void(UnitOfWork& work)>& step, std::string* error) {
+   pqxx::dbtransaction* parent = active;
+   try {
+      pqxx::subtransaction sub(*parent);
+      active = &sub;
+      step(*this);
+      sub.commit(); // RELEASE SAVEPOINT
+      active = parent;
+      return true;
+   } catch (const pqxx::broken_connection&) {
+      active = parent;
+      throw;
+   } catch (const std::exception& e) {
+      // ~subtransaction has already issued ROLLBACK TO SAVEPOINT
+      active = parent;
+      ++failures;
+      if (error) {
+         *error = e.what();
+      }
+      return false;
+   }
+}
+
+pqxx::transaction_base& UnitOfWork::transaction() {
+   return *active;
+}
+
+size_t UnitOfWork::failedSavepoints() const {
+   return failures;
+}
+
+const std::set<std::string>& UnitOfWork::touchedTables() const {
+   return touched;
+}
@@ -0,0 +1,171 @@
+// pgpool_test_insertmany: DataModifier::insertMany against a real PostgreSQL, checking that ids[i] is the id
+// of rows[i].
+//
+//   PGHOST=localhost PGPORT=5432 PGDATABASE=postgres PGUSER=postgres PGPASSWORD=... pgpool_test_insertmany
+//
+// Needs a server it may create and drop tables in (names start with pgpool_test_). Without PGHOST it
+// prints why and exits 77, which ctest reports as skipped. Prints one line per check, non-zero on failure.
+
+#include "DataModifier.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+constexpr int    kSkipped = 77;
+constexpr size_t kRows    = 2500; // two full 1000-row chunks plus a 500-row tail
+
+struct CheckFailed : std::runtime_error {
+   using std::runtime_error::runtime_error;
+};
+
+void expect(bool condition, const std::string& what) {
+   if (!condition) {
+      throw CheckFailed(what);
+   }
+}
+
+std::string env(const char* name, const char* fallback) {
+   const char* value = std::getenv(name);
+   return value ? value : fallback;
+}
+
+void execute(ConnectionPool& pool, const std::string& sql) {
+   auto                 handle = pool.getConnection();
+   pqxx::nontransaction txn(*handle);
+   txn.exec(sql);
+}
+
+// rows[i] = (seq = first + i, label = "row <first + i>"), with every 7th label NULL
+std::vector<DataModifier::Row> numberedRows(int first, size_t count) {
+   std::vector<DataModifier::Row> rows;
+   rows.reserve(count);
+   for (size_t i = 0; i < count; ++i) {
+      int seq = first + static_cast<int>(i);
+      rows.push_back({std::to_string(seq), i % 7 == 0 ? std::nullopt : std::optional("row " + std::to_string(seq))});
+   }
+   return rows;
+}
+
+// Every returned id must name the row built from the same input position
+void expectIdsMatchRows(ConnectionPool& pool, const std::string& table, const std::vector<int>& ids, int first,
+                        size_t count) {
+   expect(ids.size() == count, "got " + std::to_string(ids.size()) + " ids for " + std::to_string(count) + " rows");
+   expect(std::is_sorted(ids.begin(), ids.end()), "ids are not ascending");
+
+   auto                         handle = pool.getConnection();
+   pqxx::nontransaction         txn(*handle);
+   std::unordered_map<int, int> seq_by_id;
+   for (auto const& row : txn.exec("SELECT id, seq FROM " + txn.quote_name(table))) {
+      seq_by_id[row[0].as<int>()] = row[1].as<int>();
+   }
+   for (size_t i = 0; i < ids.size(); ++i) {
+      auto it = seq_by_id.find(ids[i]);
+      expect(it != seq_by_id.end(), "id " + std::to_string(ids[i]) + " is not in the table");
+      expect(it->second == first + static_cast<int>(i), "ids[" + std::to_string(i) + "] = " + std::to_string(ids[i]) +
+                                                            " holds seq " + std::to_string(it->second) + ", expected " +
+                                                            std::to_string(first + static_cast<int>(i)));
+   }
+}
+
+void serialColumn(ConnectionPool& pool, DataModifier& data) {
+   execute(pool, "CREATE TABLE pgpool_test_serial (id serial PRIMARY KEY, seq int NOT NULL, label text)");
+   std::vector<int> ids = data.insertMany("pgpool_test_serial", {"seq", "label"}, numberedRows(0, kRows));
+   expectIdsMatchRows(pool, "pgpool_test_serial", ids, 0, kRows);
+}
+
+void identityColumn(ConnectionPool& pool, DataModifier& data) {
+   execute(pool, "CREATE TABLE pgpool_test_identity "
+                 "(id int GENERATED ALWAYS AS IDENTITY PRIMARY KEY, seq int NOT NULL, label text)");
+   std::vector<int> ids = data.insertMany("pgpool_test_identity", {"seq", "label"}, numberedRows(0, kRows));
+   expectIdsMatchRows(pool, "pgpool_test_identity", ids, 0, kRows);
+}
+
+// Two batches drawing from one sequence at once, so their ids can interleave
+void concurrentBatches(ConnectionPool& pool, DataModifier& data) {
+   execute(pool, "CREATE TABLE pgpool_test_concurrent (id serial PRIMARY KEY, seq int NOT NULL, label text)");
+   std::vector<int> first_ids;
+   std::vector<int> second_ids;
+   std::thread      other([&] {
+      second_ids = data.insertMany("pgpool_test_concurrent", {"seq", "label"}, numberedRows(100000, kRows));
+   });
+   first_ids = data.insertMany("pgpool_test_concurrent", {"seq", "label"}, numberedRows(0, kRows));
+   other.join();
+   expectIdsMatchRows(pool, "pgpool_test_concurrent", first_ids, 0, kRows);
+   expectIdsMatchRows(pool, "pgpool_test_concurrent", second_ids, 100000, kRows);
+}
+
+void rejectsUnusableTables(ConnectionPool& pool, DataModifier& data) {
+   execute(pool, "CREATE TABLE pgpool_test_plain (id int, seq int)");
+   bool threw = false;
+   try {
+      data.insertMany("pgpool_test_plain", {"seq"}, {{std::optional<std::string>("1")}});
+   } catch (const std::invalid_argument&) {
+      threw = true;
+   }
+   expect(threw, "a table whose id has no sequence was accepted");
+
+   threw = false;
+   try {
+      data.insertMany("pgpool_test_serial", {"id", "seq"}, {{std::optional<std::string>("1"), std::nullopt}});
+   } catch (const std::invalid_argument&) {
+      threw = true;
+   }
+   expect(threw, "an explicit id column was accepted");
+}
+} // namespace
+
+int main() {
+   if (!std::getenv("PGHOST")) {
+      std::cout << "pgpool_test_insertmany: PGHOST is not set, skipping" << std::endl;
+      return kSkipped;
+   }
+   const std::string connection_string = "host=" + env("PGHOST", "") + " port=" + env("PGPORT", "5432") +
+                                         " dbname=" + env("PGDATABASE", "postgres") +
+                                         " user=" + env("PGUSER", "postgres") + " password=" + env("PGPASSWORD", "");
+
+   std::shared_ptr<ConnectionPool> pool;
+   try {
+      pool = std::make_shared<ConnectionPool>(connection_string, PoolOptions{1, 4});
+   } catch (const std::exception& e) {
+      std::cerr << "pgpool_test_insertmany: " << e.what() << std::endl;
+      return 2;
+   }
+   DataModifier data(pool);
+
+   const std::vector<std::string> tables = {"pgpool_test_serial", "pgpool_test_identity", "pgpool_test_concurrent",
+                                            "pgpool_test_plain"};
+   auto                           dropTables = [&] {
+      for (const auto& table : tables) {
+         execute(*pool, "DROP TABLE IF EXISTS " + table);
+      }
+   };
+   dropTables();
+
+   const std::vector<std::pair<const char*, std::function<void()>>> checks = {
+       {"serial id", [&] { serialColumn(*pool, data); }},
+       {"identity id", [&] { identityColumn(*pool, data); }},
+       {"concurrent batches", [&] { concurrentBatches(*pool, data); }},
+       {"unusable tables", [&] { rejectsUnusableTables(*pool, data); }},
+   };
+   int failed = 0;
+   for (const auto& [name, check] : checks) {
+      try {
+         check();
+         std::cout << "ok    " << name << std::endl;
+      } catch (const std::exception& e) {
+         ++failed;
+         std::cout << "FAIL  " << name << ": " << e.what() << std::endl;
+      }
+   }
+   dropTables();
+   return failed == 0 ? 0 : 1;
+}